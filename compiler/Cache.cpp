@@ -0,0 +1,106 @@
+#include "Cache.hpp"
+#include "Compiler.hpp"
+
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Support/Process.h"
+
+#include <thread>
+
+namespace compiler {
+
+    std::string hashString(std::string_view data) {
+        return llvm::toHex(llvm::SHA1::hash(llvm::arrayRefFromStringRef(data)), true);
+    }
+
+    std::string optionsKey(const parser::CompileOptions& options) {
+        std::string cpu, features;
+        parser::Parser::getTargetCPU(options, cpu, features);
+
+        return std::string("c-cash ") + CCASH_VERSION + " llvm " + LLVM_VERSION_STRING
+            + " " + llvm::sys::getDefaultTargetTriple()
+            + " O" + std::to_string(options.optLevel) + " s" + std::to_string(options.sizeLevel)
+            + " cpu=" + cpu + " features=" + features
+            + " ssa=" + std::to_string(options.ssaLocals)
+            + " eval=" + std::to_string(options.evalCalls)
+            + " bounds=" + std::to_string(options.boundsChecks)
+            + " thinlto=" + std::to_string(options.thinLTO);
+    }
+
+    // write file next to its final path and rename it, so other builds never see half-written files
+    bool writeCacheFile(const fs::path& path, const std::string& data) {
+        fs::path tmp = path;
+        tmp += ".tmp" + std::to_string(llvm::sys::Process::getProcessId()) + "-" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+
+        std::ofstream file(tmp, std::ios::binary);
+        if (!file) return false;
+        file << data;
+        file.close();
+
+        std::error_code ec;
+        fs::rename(tmp, path, ec);
+        return !ec;
+    }
+
+    std::string sourceKey(std::string_view code, const parser::CompileOptions& options) {
+        std::string key = optionsKey(options) + '\n';
+        key += code;
+        return hashString(key);
+    }
+
+    std::optional<std::string> readCacheFile(const fs::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return std::nullopt;
+        return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    }
+
+    std::optional<std::vector<std::string>> loadCachedImports(const std::string& sourceKey, const parser::CompileOptions& options) {
+        std::ifstream manifest(fs::path(options.cacheDir) / (sourceKey + ".deps"));
+        if (!manifest) return std::nullopt;
+
+        std::vector<std::string> imports;
+        std::string import;
+        while (std::getline(manifest, import)) {
+            if (!import.empty()) imports.emplace_back(import);
+        }
+        return imports;
+    }
+
+    void storeCachedImports(const std::string& sourceKey, const std::vector<std::string>& imports, const parser::CompileOptions& options) {
+        fs::path dir(options.cacheDir);
+
+        std::error_code ec;
+        fs::create_directories(dir, ec);
+        if (ec) return;
+
+        std::string manifest;
+        for (auto& import : imports) {
+            manifest += import + '\n';
+        }
+        writeCacheFile(dir / (sourceKey + ".deps"), manifest);
+    }
+
+    std::optional<std::string> loadCachedModule(const std::string& key, const std::string& objName, const parser::CompileOptions& options) {
+        fs::path dir(options.cacheDir);
+
+        std::optional<std::string> declarations = readCacheFile(dir / (key + ".decl.bc"));
+        if (!declarations.has_value()) return std::nullopt;
+
+        std::error_code ec;
+        fs::copy_file(dir / (key + ".o"), objName, fs::copy_options::overwrite_existing, ec);
+        if (ec) return std::nullopt;
+
+        return declarations;
+    }
+
+    void storeCachedModule(const std::string& key, const std::string& declarations, const std::string& objName, const parser::CompileOptions& options) {
+        fs::path dir(options.cacheDir);
+
+        std::optional<std::string> objData = readCacheFile(objName);
+        if (!objData.has_value()) return;
+
+        writeCacheFile(dir / (key + ".o"), objData.value());
+        writeCacheFile(dir / (key + ".decl.bc"), declarations);
+    }
+
+}
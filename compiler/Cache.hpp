@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+
+#include "../parser/Parser.hpp"
+
+#include <filesystem>
+namespace fs = std::filesystem;
+
+namespace compiler {
+
+    std::string hashString(std::string_view data);
+    std::string optionsKey(const parser::CompileOptions& options);
+    std::string sourceKey(std::string_view code, const parser::CompileOptions& options);
+
+    std::optional<std::vector<std::string>> loadCachedImports(const std::string& sourceKey, const parser::CompileOptions& options);
+    void storeCachedImports(const std::string& sourceKey, const std::vector<std::string>& imports, const parser::CompileOptions& options);
+
+    std::optional<std::string> loadCachedModule(const std::string& key, const std::string& objName, const parser::CompileOptions& options);
+    void storeCachedModule(const std::string& key, const std::string& declarations, const std::string& objName, const parser::CompileOptions& options);
+
+}
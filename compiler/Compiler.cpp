@@ -1,4 +1,7 @@
 #include "Compiler.hpp"
+#include "Cache.hpp"
+#include "Resolver.hpp"
+#include "Evaluator.hpp"
 
 namespace compiler {
 
@@ -8,23 +11,73 @@ namespace compiler {
     }
 
 
-    llvm::LLVMContext llvmContext;
-    llvm::IRBuilder<> Builder(llvmContext);
+    // every thread compiles its own module, so it gets its own context and builder
+    thread_local llvm::LLVMContext llvmContext;
+    thread_local llvm::IRBuilder<> Builder(llvmContext);
+
+    // variables of the current function by slot, an alloca or the current register value
+    thread_local std::vector<llvm::Value*> slots;
+    thread_local std::vector<bool> ssaSlots;     // slot holds a register value instead of an alloca
+    thread_local std::vector<bool> addressTaken; // slot has to live in memory
+    thread_local std::vector<std::string_view> slotNames;
+    thread_local bool ssaLocals = true;
+    thread_local bool evalCalls = true;
+    thread_local bool boundsChecks = false;
+    thread_local bool inConstFunction = false;
+
+    // pure functions of the module being compiled
+    thread_local Evaluator* evaluator = nullptr;
+
+    // owner of the scopes of the module being compiled
+    thread_local parser::Arena* arena = nullptr;
+
+    // values of the statements lowered in the current function
+    thread_local llvm::DenseMap<parser::Statement*, llvm::Value*> loweredValues;
+
+    // functions of the module being compiled, by symbol id
+    thread_local std::unordered_map<int, llvm::Function*> functions;
     
-    llvm::Module* compileModule(std::vector<parser::Statement*> module, const std::string& name, const std::string& path) {
+    llvm::Module* compileModule(std::vector<parser::Statement*> module, const std::string& name, const std::vector<std::string>& imports, parser::Arena& moduleArena, const parser::CompileOptions& options) {
         // create module
         llvm::Module* mod = new llvm::Module(name, llvmContext);
+        arena = &moduleArena;
+
+        // declarations of already compiled imports
+        functions.clear();
+        for (auto& import : imports) {
+            declareImport(import, mod);
+        }
+        for (llvm::Function& f : mod->getFunctionList()) {
+            functions[tokenizer::internSymbol(f.getName())] = &f;
+        }
+
+        // every function is resolved first, so calls can be evaluated before their callee is compiled
+        Evaluator moduleEvaluator;
+        evaluator = &moduleEvaluator;
+        std::vector<FunctionSlots> resolved;
+        for (parser::Statement* s : module) {
+            if (parser::FunctionDefinition* f = llvm::dyn_cast<parser::FunctionDefinition>(s)) {
+                resolved.push_back(resolveFunction(f));
+                moduleEvaluator.addFunction(f, resolved.back().names.size());
+            }
+        }
+        moduleEvaluator.analyze();
 
+        size_t index = 0;
         for (parser::Statement* s : module) {
-            if (s->type == parser::StatementType::FUNCTION_DEFINITION) {
-                compileFunction(s, mod);
-            } else if (s->type == parser::StatementType::IMPORT) {
-                compileImport(s, mod, path);
+            if (parser::FunctionDefinition* f = llvm::dyn_cast<parser::FunctionDefinition>(s)) {
+                if (f->isConst && !moduleEvaluator.isPure(f->symbol)) {
+                    throw std::runtime_error("const function " + std::string(f->value) + " can not be evaluated at compile time");
+                }
+                compileFunction(f, resolved[index++], mod, options);
             }
         }
+        evaluator = nullptr;
         
-        std::cout << "\u001B[36m" << mod->getSourceFileName() << " \u001B[32mmodule llvm ir code:\u001B[0m\n";
-        mod->print(llvm::errs(), nullptr);
+        if (options.verbose) {
+            std::cout << "\u001B[36m" << mod->getSourceFileName() << " \u001B[32mmodule llvm ir code:\u001B[0m\n";
+            mod->print(llvm::errs(), nullptr);
+        }
 
         // llvm::FunctionPassManager* pm = new llvm::FunctionPassManager(mod);
 
@@ -41,55 +94,119 @@ namespace compiler {
         return path.substr(path.find_last_of("/\\") + 1);
     }
 
-    llvm::Module* compileImport(parser::Statement* statement, llvm::Module* mod, const std::string& path) {
-        // get code
-        std::ifstream file;
+    void declareFunctions(llvm::Module* from, llvm::Module* mod) {
+        for (llvm::Function& m : from->getFunctionList()) {
+            if (mod->getFunction(m.getName()) != nullptr) continue;
+            llvm::Function::Create(m.getFunctionType(), llvm::Function::ExternalLinkage, m.getName(), mod);
+        }
+    }
 
-        fs::path a (path);
-        fs::path b (statement->value);
-        fs::path r = a.parent_path()/b;
-            
-        file.open(r);
+    std::string writeBitcode(llvm::Module* mod) {
+        std::string bitcode;
+        llvm::raw_string_ostream os(bitcode);
+        llvm::WriteBitcodeToFile(*mod, os);
+        os.flush();
 
-        std::string line, allCode="";
-        while (std::getline(file, line)) {
-            allCode += line + '\n';
-        }
+        return bitcode;
+    }
 
-        std::cout << "\u001B[32mCompiling module \u001B[36m" << statement->value << "\u001B[0m\n";
+    std::string writeDeclarations(llvm::Module* from) {
+        llvm::Module declarations(from->getName(), from->getContext());
+        declareFunctions(from, &declarations);
 
-        // tokenize and parse
-        std::vector<tokenizer::Token> tokens = tokenizer::tokenize(allCode);
+        return writeBitcode(&declarations);
+    }
 
-        for (auto t : tokens) {
-            t.debug_print();
+    void declareImport(const std::string& declarations, llvm::Module* mod) {
+        llvm::Expected<std::unique_ptr<llvm::Module>> im = llvm::parseBitcodeFile(llvm::MemoryBufferRef(declarations, "declarations"), llvmContext);
+        if (!im) {
+            llvm::errs() << "Could not read module declarations: " << llvm::toString(im.takeError()) << '\n';
+            return;
         }
+        declareFunctions(im.get().get(), mod);
+    }
 
-        std::vector<parser::Statement*> AST = parser::Parser::parse(tokens);
+    void collectAssignedSlots(parser::Statement* statement, std::vector<int>& assigned) {
+        if (statement->type == parser::StatementType::VARIABLE_ASSIGNMENT) {
+            assigned.push_back(statement->slot);
+        }
+        for (parser::Statement* s : statement->statements) {
+            collectAssignedSlots(s, assigned);
+        }
+    }
 
-        for (auto s : AST) {
-            s->debug_print(0);
-        }  
+    bool isSSALocal(int slot, llvm::Type* type) {
+        return ssaLocals && !type->isArrayTy() && !addressTaken[slot];
+    }
 
-        // compile
-        llvm::Module* im = compileModule(AST, base_name(statement->value), r);
-        // declare functions in this module
-        for (llvm::Function& m : im->getFunctionList()) {
-            llvm::Function::Create(m.getFunctionType(), llvm::Function::ExternalLinkage, m.getName(), mod);
+    void setSlot(parser::Scope* scope, int slot, llvm::Value* value) {
+        scope->saved.try_emplace(slot, slots[slot]);
+        slots[slot] = value;
+    }
+
+    // puts back the values from before the scope, the scope keeps the values it ended with
+    void restoreScope(parser::Scope* scope) {
+        for (auto& s : scope->saved) {
+            std::swap(slots[s.first], s.second);
         }
-        std::string objName = base_name(statement->value) + ".o";
-        parser::Parser::saveCompilation(im, objName);
+    }
 
-        return im;
+    // the values the scope ended with stay, so the parent has to be able to restore them
+    void leaveScope(parser::Scope* scope) {
+        for (auto& s : scope->saved) {
+            scope->parent->saved.try_emplace(s.first, s.second);
+        }
     }
 
-    llvm::Function* compileFunction(parser::Statement* statement, llvm::Module* mod) {
+    void mergeSSAValues(parser::Scope* scope, const std::vector<std::pair<parser::Scope*, llvm::BasicBlock*>>& branches) {
+        // variables defined inside a branch have no value here and are not visible anymore
+        std::vector<int> changed;
+        for (auto& branch : branches) {
+            if (branch.first == nullptr) continue;
+            for (auto& s : branch.first->saved) {
+                if (slots[s.first] != nullptr) changed.push_back(s.first);
+            }
+        }
+        std::sort(changed.begin(), changed.end());
+        changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+
+        for (int slot : changed) {
+            std::vector<std::pair<llvm::Value*, llvm::BasicBlock*>> incoming;
+            bool same = true;
+            for (auto& branch : branches) {
+                // branches that end with return never reach this block
+                if (branch.second == nullptr) continue;
+
+                llvm::Value* v = slots[slot];
+                if (branch.first != nullptr) {
+                    auto it = branch.first->saved.find(slot);
+                    if (it != branch.first->saved.end()) v = it->second;
+                }
+                if (!incoming.empty() && incoming[0].first != v) same = false;
+                incoming.emplace_back(v, branch.second);
+            }
+
+            if (incoming.empty()) continue;
+            if (same) {
+                setSlot(scope, slot, incoming[0].first);
+                continue;
+            }
+
+            llvm::PHINode* phi = Builder.CreatePHI(incoming[0].first->getType(), incoming.size(), llvm::StringRef(slotNames[slot]));
+            for (auto& in : incoming) {
+                phi->addIncoming(in.first, in.second);
+            }
+            setSlot(scope, slot, phi);
+        }
+    }
+
+    llvm::Function* compileFunction(parser::FunctionDefinition* statement, FunctionSlots& resolved, llvm::Module* mod, const parser::CompileOptions& options) {
 
         std::vector<llvm::Type*> argsT;
 
         // arguments declaration
-        for (auto arg : statement->args) {
-            argsT.emplace_back(compileType(arg.first));
+        for (auto& arg : statement->args) {
+            argsT.emplace_back(compileType(arg.type));
         }
 
         // function type
@@ -97,22 +214,40 @@ namespace compiler {
 
         // function
         llvm::Function* F = llvm::Function::Create(FT, llvm::Function::ExternalLinkage, statement->value, mod);
+        functions[statement->symbol] = F;
 
         // function block
         llvm::BasicBlock* entryBlock = llvm::BasicBlock::Create(llvmContext, "entry", F);
 
         Builder.SetInsertPoint(entryBlock);
-        parser::Scope* funcScope = new parser::Scope();
-
-        // arguments definition
-        int index = 0;
+        parser::Scope* funcScope = arena->scope();
+
+        // variables are bound to slots already, find locals that can be kept in registers
+        ssaLocals = options.ssaLocals;
+        evalCalls = options.evalCalls;
+        boundsChecks = options.boundsChecks;
+        inConstFunction = statement->isConst;
+        addressTaken = std::move(resolved.addressTaken);
+        slotNames = std::move(resolved.names);
+        slots.assign(slotNames.size(), nullptr);
+        ssaSlots.assign(slotNames.size(), false);
+        loweredValues.clear();
+
+        // arguments definition, they take the first slots
+        int slot = 0;
         for (auto& arg : F->args()) {
-            arg.setName(statement->args[index++].second);
+            arg.setName(llvm::StringRef(statement->args[slot].name));
+
+            if (isSSALocal(slot, arg.getType())) {
+                slots[slot] = &arg;
+                ssaSlots[slot++] = true;
+                continue;
+            }
 
             llvm::AllocaInst* alloca = allocateEntry(F, arg.getType(), std::string(arg.getName()));
             Builder.CreateStore(&arg, alloca);
             
-            funcScope->namedValues[std::string(arg.getName())] = alloca;
+            slots[slot++] = alloca;
         }
         
         for (parser::Statement* s : statement->statements) {
@@ -124,9 +259,9 @@ namespace compiler {
         return F;
     }
 
-    llvm::AllocaInst* allocateEntry(llvm::Function* func, llvm::Type* t, const std::string& name) {
+    llvm::AllocaInst* allocateEntry(llvm::Function* func, llvm::Type* t, std::string_view name) {
         llvm::IRBuilder<> tmpB(&func->getEntryBlock(), func->getEntryBlock().begin());
-        return tmpB.CreateAlloca(t, 0, name.c_str());
+        return tmpB.CreateAlloca(t, 0, llvm::StringRef(name));
     }
 
     llvm::ReturnInst* compileReturn(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope) {
@@ -137,12 +272,15 @@ namespace compiler {
     }
 
     llvm::Value* compileGetAlloca(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope) {
-        return scope->namedValues[statement->value];
+        return slots[statement->slot];
     }
 
     llvm::Value* compileVariableCall(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope) {
-        return Builder.CreateLoad(static_cast<llvm::AllocaInst*>(scope->namedValues[statement->value])->getAllocatedType(), 
-        scope->namedValues[statement->value], statement->value);
+        llvm::Value* value = slots[statement->slot];
+        if (ssaSlots[statement->slot]) {
+            return value;
+        }
+        return Builder.CreateLoad(static_cast<llvm::AllocaInst*>(value)->getAllocatedType(), value, statement->value);
     }
 
     llvm::Function* createFDeclaration(llvm::Module* mod, const std::string& name, llvm::Type* rt, std::vector<llvm::Type*> at, bool varargs) {
@@ -152,13 +290,16 @@ namespace compiler {
     }
 
     llvm::Function* compileIntrinsic(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope) {
+        static const int printfSymbol = tokenizer::internSymbol("printf");
+        static const int scanfSymbol = tokenizer::internSymbol("scanf");
+
         // printf intrinsic
-        if (statement->value == "printf") {
+        if (statement->symbol == printfSymbol) {
             std::vector<llvm::Type*> at { llvm::PointerType::get(llvm::Type::getInt8Ty(llvmContext), 0) };
             return createFDeclaration(mod, "printf", llvm::IntegerType::getInt32Ty(llvmContext), at, true);
         }
         // scanf intrinsic
-        if (statement->value == "scanf") {
+        if (statement->symbol == scanfSymbol) {
             std::vector<llvm::Type*> at { llvm::PointerType::get(llvm::Type::getInt8Ty(llvmContext), 0) };
             return createFDeclaration(mod, "scanf", llvm::IntegerType::getInt32Ty(llvmContext), at, true);
         }
@@ -166,72 +307,356 @@ namespace compiler {
         return nullptr;
     }
 
+    // literals and math, comparisons, casts and const calls of them, decided on the tree so the options do not matter
+    bool isConstantExpression(parser::Statement* statement) {
+        switch (statement->type) {
+            case parser::StatementType::INTEGER_LITERAL:
+            case parser::StatementType::BOOLEAN_LITERAL:
+            case parser::StatementType::LONG_LITERAL:
+            case parser::StatementType::CHAR_LITERAL:
+            case parser::StatementType::DOUBLE_LITERAL:
+                return true;
+            case parser::StatementType::FUNCTION_CALL:
+                if (!evaluator->isConst(statement->symbol)) return false;
+                break;
+            case parser::StatementType::MATH:
+            case parser::StatementType::LOGIC_EXPRESSION:
+            case parser::StatementType::TYPE_CAST:
+                break;
+            default:
+                return false;
+        }
+        for (parser::Statement* s : statement->statements) {
+            if (!isConstantExpression(s)) return false;
+        }
+        return true;
+    }
+
     llvm::Value* compileFunctionCall(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope) {
         llvm::Function* F;
 
-        compileIntrinsic(statement, mod, func, scope);
-
-        F = mod->getFunction(statement->value);
-        if (!F) return nullptr;
+        F = compileIntrinsic(statement, mod, func, scope);
+        if (!F) {
+            auto it = functions.find(statement->symbol);
+            if (it == functions.end()) {
+                if (llvm::Value* value = compileVectorBuiltin(statement, mod, func, scope)) return value;
+                throw std::runtime_error("Unknown function " + std::string(statement->value));
+            }
+            F = it->second;
+        }
 
         std::vector<llvm::Value*> args;
         for (auto arg : statement->statements) {
             args.emplace_back(compileValueExpression(arg, mod, func, scope));
         }
 
+        // only const functions themselves may call const functions with other arguments than constant expressions
+        bool isConst = evaluator->isConst(statement->symbol);
+        if (isConst && !inConstFunction && !isConstantExpression(statement)) {
+            throw std::runtime_error("Call of const function " + std::string(statement->value) + " needs constant arguments");
+        }
+
+        // calls of pure functions with constant arguments are evaluated now
+        if (evalCalls || isConst) {
+            if (llvm::Constant* value = evaluator->evaluateCall(statement->symbol, args)) return value;
+        }
+        if (isConst && !inConstFunction) {
+            throw std::runtime_error("Call of const function " + std::string(statement->value) + " can not be evaluated at compile time");
+        }
+
         return Builder.CreateCall(F, args, "calltmp");
     }
 
+    // extract(v, lane), insert(v, value, lane), select(mask, a, b) and shuffle(a, b, lanes...),
+    // nullptr for other names, functions of the same name take precedence
+    llvm::Value* compileVectorBuiltin(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope) {
+        static const int extractSymbol = tokenizer::internSymbol("extract");
+        static const int insertSymbol = tokenizer::internSymbol("insert");
+        static const int selectSymbol = tokenizer::internSymbol("select");
+        static const int shuffleSymbol = tokenizer::internSymbol("shuffle");
+
+        int symbol = statement->symbol;
+        if (symbol != extractSymbol && symbol != insertSymbol && symbol != selectSymbol && symbol != shuffleSymbol) return nullptr;
+
+        std::string name(statement->value);
+        size_t argCount = statement->statements.size();
+        if (argCount < (symbol == extractSymbol ? 2 : 3) || (symbol != shuffleSymbol && argCount > (symbol == extractSymbol ? 2 : 3))) {
+            throw std::runtime_error("Wrong number of arguments for " + name);
+        }
+
+        std::vector<llvm::Value*> args;
+        for (auto arg : statement->statements) {
+            args.emplace_back(compileValueExpression(arg, mod, func, scope));
+        }
+
+        llvm::FixedVectorType* vt = llvm::dyn_cast<llvm::FixedVectorType>(args[symbol == selectSymbol ? 1 : 0]->getType());
+        if (vt == nullptr) throw std::runtime_error(name + " expects a vector");
+
+        if (symbol == extractSymbol || symbol == insertSymbol) {
+            llvm::Value* lane = args[symbol == extractSymbol ? 1 : 2];
+            if (!lane->getType()->isIntegerTy()) throw std::runtime_error(name + " expects an integer lane");
+            llvm::ConstantInt* constantLane = llvm::dyn_cast<llvm::ConstantInt>(lane);
+            if (constantLane != nullptr && (constantLane->getSExtValue() < 0 || constantLane->getSExtValue() >= vt->getNumElements())) {
+                throw std::runtime_error(name + " lane " + std::to_string(constantLane->getSExtValue()) + " is out of range for " + std::to_string(vt->getNumElements()) + " lanes");
+            }
+            if (symbol == extractSymbol) return Builder.CreateExtractElement(args[0], lane, "lanetmp");
+
+            llvm::Type* from = args[1]->getType();
+            if (!from->isIntegerTy() && !from->isFloatingPointTy()) throw std::runtime_error(name + " expects a number as value");
+            return Builder.CreateInsertElement(args[0], compileLaneCast(args[1], vt->getElementType()), lane, "vectmp");
+        }
+        if (symbol == selectSymbol) {
+            llvm::Type* maskType = llvm::VectorType::get(llvm::Type::getInt1Ty(llvmContext), vt->getElementCount());
+            if (args[0]->getType() != maskType || args[2]->getType() != vt) {
+                throw std::runtime_error(name + " expects a bool mask and two vectors of the same type");
+            }
+            return Builder.CreateSelect(args[0], args[1], args[2], "seltmp");
+        }
+
+        if (args[1]->getType() != vt) throw std::runtime_error(name + " expects two vectors of the same type");
+
+        // lane i of the result is lane lanes[i] of a and b put one after the other
+        llvm::SmallVector<int, 16> mask;
+        for (size_t i = 2; i < args.size(); i++) {
+            llvm::ConstantInt* lane = llvm::dyn_cast<llvm::ConstantInt>(args[i]);
+            if (lane == nullptr || lane->getSExtValue() < 0 || lane->getSExtValue() >= 2 * vt->getNumElements()) {
+                throw std::runtime_error("shuffle lanes have to be constants below twice the vector width");
+            }
+            mask.push_back(lane->getSExtValue());
+        }
+        return Builder.CreateShuffleVector(args[0], args[1], mask, "shuffletmp");
+    }
+
+    // a scalar next to a vector is used for every lane
+    void splatOperands(llvm::Value*& a, llvm::Value*& b) {
+        llvm::FixedVectorType* va = llvm::dyn_cast<llvm::FixedVectorType>(a->getType());
+        llvm::FixedVectorType* vb = llvm::dyn_cast<llvm::FixedVectorType>(b->getType());
+        if (va != nullptr && vb == nullptr) {
+            b = Builder.CreateVectorSplat(va->getNumElements(), b);
+        } else if (vb != nullptr && va == nullptr) {
+            a = Builder.CreateVectorSplat(vb->getNumElements(), a);
+        }
+    }
+
     llvm::Value* compileVariableAssignment(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope) {
         llvm::Value* val = compileValueExpression(statement->statements[0], mod, func, scope);
-        Builder.CreateStore(val, scope->namedValues[statement->value]);
+        if (ssaSlots[statement->slot]) {
+            setSlot(scope, statement->slot, val);
+            return val;
+        }
 
-        return Builder.CreateLoad(static_cast<llvm::AllocaInst*>(scope->namedValues[statement->value])->getAllocatedType(), 
-        scope->namedValues[statement->value], statement->value);
+        Builder.CreateStore(val, slots[statement->slot]);
+        return val;
     }
 
     llvm::Value* compileVariableDefinition(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope) {
-        llvm::AllocaInst* alloca = allocateEntry(func, compileType(statement->dataType), statement->value);
+        llvm::Type* type = compileType(llvm::cast<parser::Definition>(statement)->dataType);
+
+        if (isSSALocal(statement->slot, type)) {
+            llvm::Value* initialValue = llvm::UndefValue::get(type);
+            if (statement->statements.size() > 0) {
+                initialValue = compileValueExpression(statement->statements[0], mod, func, scope);
+            }
+
+            setSlot(scope, statement->slot, initialValue);
+            ssaSlots[statement->slot] = true;
+            return initialValue;
+        }
 
-        scope->namedValues[statement->value] = alloca;
+        llvm::AllocaInst* alloca = allocateEntry(func, type, statement->value);
+
+        slots[statement->slot] = alloca;
         if (statement->statements.size() <= 0) {
-            return Builder.CreateLoad(alloca->getAllocatedType(), scope->namedValues[statement->value], statement->value);
+            return Builder.CreateLoad(alloca->getAllocatedType(), alloca, statement->value);
         }
 
         llvm::Value* initialValue = compileValueExpression(statement->statements[0], mod, func, scope);
         Builder.CreateStore(initialValue, alloca);
 
-        return Builder.CreateLoad(alloca->getAllocatedType(), scope->namedValues[statement->value], statement->value);
+        return initialValue;
+    }
+
+    // hints like @unroll(4) follow the four parts of a for loop, nullptr when there are none
+    llvm::MDNode* compileLoopHints(parser::Statement* statement) {
+        auto property = [](llvm::StringRef name, llvm::Constant* value) -> llvm::Metadata* {
+            llvm::SmallVector<llvm::Metadata*, 2> ops { llvm::MDString::get(llvmContext, name) };
+            if (value != nullptr) ops.push_back(llvm::ConstantAsMetadata::get(value));
+            return llvm::MDNode::get(llvmContext, ops);
+        };
+        llvm::Constant* enable = llvm::ConstantInt::getTrue(llvmContext);
+        llvm::Constant* disable = llvm::ConstantInt::getFalse(llvmContext);
+
+        // the first operand is the node itself
+        llvm::SmallVector<llvm::Metadata*, 4> ops { nullptr };
+        for (size_t i = 4; i < statement->statements.size(); i++) {
+            parser::Statement* hint = statement->statements[i];
+            if (hint->value == "novectorize") {
+                ops.push_back(property("llvm.loop.vectorize.enable", disable));
+                continue;
+            }
+
+            int n = std::stoi(std::string(hint->statements[0]->value));
+            llvm::Constant* count = llvm::ConstantInt::get(llvm::Type::getInt32Ty(llvmContext), n);
+            if (hint->value == "unroll") {
+                ops.push_back(n > 1 ? property("llvm.loop.unroll.count", count) : property("llvm.loop.unroll.disable", nullptr));
+            } else if (hint->value == "vectorize") {
+                ops.push_back(property("llvm.loop.vectorize.width", count));
+                ops.push_back(property("llvm.loop.vectorize.enable", n > 1 ? enable : disable));
+            }
+        }
+        if (ops.size() == 1) return nullptr;
+
+        llvm::MDNode* loopID = llvm::MDNode::getDistinct(llvmContext, ops);
+        loopID->replaceOperandWith(0, loopID);
+        return loopID;
+    }
+
+    // the end condition is lowered twice, as guard in front of the loop and as test in the latch
+    void forgetLowered(parser::Statement* statement) {
+        loweredValues.erase(statement);
+        for (parser::Statement* s : statement->statements) {
+            forgetLowered(s);
+        }
+    }
+
+    // loop counters inside the loop bodies being compiled, they stay in [first, last]
+    struct CounterRange {
+        int slot;
+        int64_t first;
+        int64_t last;
+    };
+    thread_local std::vector<CounterRange> counterRanges;
+
+    // for (i = C; i < N; i = i + S) with constant C and N, a positive step and a body that does not change i
+    std::optional<CounterRange> loopCounterRange(parser::Statement* statement) {
+        parser::Statement* before = statement->statements[0];
+        parser::Statement* cond = statement->statements[1];
+        parser::Statement* after = statement->statements[2];
+
+        if (cond->type != parser::StatementType::LOGIC_EXPRESSION || (cond->value != "<" && cond->value != "<=")) return std::nullopt;
+        parser::Statement* counter = cond->statements[0];
+        if (counter->type != parser::StatementType::VARIABLE_CALL || addressTaken[counter->slot]) return std::nullopt;
+        int slot = counter->slot;
+
+        if ((before->type != parser::StatementType::VARIABLE_DEFINITON && before->type != parser::StatementType::VARIABLE_ASSIGNMENT) || before->slot != slot) return std::nullopt;
+        if (after->type != parser::StatementType::VARIABLE_ASSIGNMENT || after->slot != slot) return std::nullopt;
+        parser::Statement* step = after->statements[0];
+        if (step->type != parser::StatementType::MATH || step->value != "+"
+            || step->statements[0]->type != parser::StatementType::VARIABLE_CALL || step->statements[0]->slot != slot
+            || step->statements[1]->type != parser::StatementType::INTEGER_LITERAL || std::stoi(std::string(step->statements[1]->value)) <= 0) {
+            return std::nullopt;
+        }
+
+        std::vector<int> assigned;
+        collectAssignedSlots(statement->statements[3], assigned);
+        if (std::find(assigned.begin(), assigned.end(), slot) != assigned.end()) return std::nullopt;
+
+        // the start and the bound were lowered for the guard already
+        llvm::ConstantInt* start = llvm::dyn_cast_or_null<llvm::ConstantInt>(loweredValues.lookup(before));
+        llvm::ConstantInt* bound = llvm::dyn_cast_or_null<llvm::ConstantInt>(loweredValues.lookup(cond->statements[1]));
+        if (start == nullptr || bound == nullptr) return std::nullopt;
+
+        int64_t last = bound->getSExtValue() - (cond->value == "<" ? 1 : 0);
+        return CounterRange{slot, start->getSExtValue(), last};
+    }
+
+    bool isIndexInBounds(parser::Statement* index, uint64_t length) {
+        if (index->type != parser::StatementType::VARIABLE_CALL) return false;
+        for (auto it = counterRanges.rbegin(); it != counterRanges.rend(); ++it) {
+            if (it->slot == index->slot) return it->first >= 0 && it->last < (int64_t)length;
+        }
+        return false;
     }
 
     llvm::Value* compileForStatement(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope) {
 
-        parser::Scope* loopScope = new parser::Scope(scope);
+        parser::Scope* loopScope = arena->scope(scope);
 
-        // compile before loop
+        // compile before loop and the guard that skips it when the condition starts out false
         compileValueExpression(statement->statements[0], mod, func, loopScope);
+        llvm::Value* guardCond = compileValueExpression(statement->statements[1], mod, func, loopScope);
+        llvm::BasicBlock* guardBB = Builder.GetInsertBlock();
 
-        // create loop block
+        llvm::BasicBlock* preheaderBB = llvm::BasicBlock::Create(llvmContext, "loop.preheader", func);
         llvm::BasicBlock* loopBB = llvm::BasicBlock::Create(llvmContext, "loop.body", func);
+        llvm::BasicBlock* exitBB = llvm::BasicBlock::Create(llvmContext, "loop.exit", func);
+        llvm::BasicBlock* afterLoopBB = llvm::BasicBlock::Create(llvmContext, "loop.after", func);
+
+        Builder.CreateCondBr(guardCond, preheaderBB, afterLoopBB);
+        Builder.SetInsertPoint(preheaderBB);
         Builder.CreateBr(loopBB);
 
         Builder.SetInsertPoint(loopBB);
 
-        // compile function body
+        // register variables from before the loop that it assigns get a phi
+        std::vector<int> assigned;
+        for (int i = 1; i < 4; i++) {
+            collectAssignedSlots(statement->statements[i], assigned);
+        }
+        std::sort(assigned.begin(), assigned.end());
+        assigned.erase(std::unique(assigned.begin(), assigned.end()), assigned.end());
+
+        std::vector<std::pair<int, llvm::PHINode*>> phis;
+        for (int slot : assigned) {
+            llvm::Value* v = slots[slot];
+            if (v == nullptr || !ssaSlots[slot]) continue;
+            llvm::PHINode* phi = Builder.CreatePHI(v->getType(), 2, llvm::StringRef(slotNames[slot]));
+            phi->addIncoming(v, preheaderBB);
+            setSlot(loopScope, slot, phi);
+            phis.emplace_back(slot, phi);
+        }
+
+        // compile function body, array indices by the loop counter need no bounds checks when it stays in the array
+        std::optional<CounterRange> counter = loopCounterRange(statement);
+        if (counter.has_value()) counterRanges.push_back(counter.value());
         compileExpression(statement->statements[3], mod, func, loopScope);
+        if (counter.has_value()) counterRanges.pop_back();
 
         // compile after expression
-        llvm::Value* afterExpr = compileValueExpression(statement->statements[2], mod, func, loopScope);
+        compileValueExpression(statement->statements[2], mod, func, loopScope);
         // compile end expression
+        forgetLowered(statement->statements[1]);
         llvm::Value* endCond = compileValueExpression(statement->statements[1], mod, func, loopScope);
 
-        // after loop block
-        llvm::BasicBlock* afterLoopBB = llvm::BasicBlock::Create(llvmContext, "loop.after", func);
+        llvm::BranchInst* latchBr = Builder.CreateCondBr(endCond, loopBB, exitBB);
+        if (llvm::MDNode* loopID = compileLoopHints(statement)) {
+            latchBr->setMetadata(llvm::LLVMContext::MD_loop, loopID);
+        }
+        llvm::BasicBlock* latchBB = Builder.GetInsertBlock();
 
-        Builder.CreateCondBr(endCond, loopBB, afterLoopBB);
+        for (auto& p : phis) {
+            p.second->addIncoming(slots[p.first], latchBB);
+        }
 
+        // phis of variables only assigned their own value are removed
+        for (auto& p : phis) {
+            if (p.second->getIncomingValueForBlock(latchBB) != p.second) continue;
+
+            llvm::Value* initial = p.second->getIncomingValueForBlock(preheaderBB);
+            p.second->replaceAllUsesWith(initial);
+            for (llvm::Value*& v : slots) {
+                if (v == p.second) v = initial;
+            }
+            p.second->eraseFromParent();
+            p.second = nullptr;
+        }
+
+        Builder.SetInsertPoint(exitBB);
+        Builder.CreateBr(afterLoopBB);
         Builder.SetInsertPoint(afterLoopBB);
 
+        // after the loop a variable has its value from before the loop if it was skipped, or from the last iteration,
+        // variables defined in the loop header are not visible anymore
+        for (auto& p : phis) {
+            if (p.second == nullptr || loopScope->saved[p.first] == nullptr) continue;
+
+            llvm::PHINode* phi = Builder.CreatePHI(p.second->getType(), 2, llvm::StringRef(slotNames[p.first]));
+            phi->addIncoming(p.second->getIncomingValueForBlock(preheaderBB), guardBB);
+            phi->addIncoming(slots[p.first], exitBB);
+            slots[p.first] = phi;
+        }
+        leaveScope(loopScope);
+
         return nullptr;
     }
 
@@ -253,24 +678,35 @@ namespace compiler {
 
         // compile true code
         Builder.SetInsertPoint(thenBB);
-        parser::Scope* trueScope = new parser::Scope(scope);
+        parser::Scope* trueScope = arena->scope(scope);
         compileExpression(statement->statements[1], mod, func, trueScope);
-        Builder.CreateBr(contBB);
+        restoreScope(trueScope);
+        bool thenReachesCont = !Builder.GetInsertBlock()->getTerminator();
+        if (thenReachesCont) Builder.CreateBr(contBB);
 
         thenBB = Builder.GetInsertBlock();
 
         // compile false code if exists
         Builder.SetInsertPoint(elseBB);
+        parser::Scope* falseScope = nullptr;
         if (hasElse) {
-            parser::Scope* falseScope = new parser::Scope(scope);
+            falseScope = arena->scope(scope);
             compileExpression(statement->statements[2], mod, func, falseScope);
+            restoreScope(falseScope);
         }
-        Builder.CreateBr(contBB);
+        bool elseReachesCont = !Builder.GetInsertBlock()->getTerminator();
+        if (elseReachesCont) Builder.CreateBr(contBB);
 
         elseBB = Builder.GetInsertBlock();
 
         Builder.SetInsertPoint(contBB);
 
+        // join register variables changed in either branch
+        mergeSSAValues(scope, {
+            { trueScope, thenReachesCont ? thenBB : nullptr },
+            { falseScope, elseReachesCont ? elseBB : nullptr },
+        });
+
         std::vector<llvm::Type*> types;
         std::vector<llvm::Value*> args;
         // Builder.CreateIntrinsic(llvm::Intrinsic::donothing, types, args);
@@ -281,165 +717,93 @@ namespace compiler {
 
     llvm::Value* compileMath(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope) {
         llvm::Value* av = compileValueExpression(statement->statements[0], mod, func, scope);
-        if (av->getType()->isIntegerTy()) { // integer
+        llvm::Value* bv = compileValueExpression(statement->statements[1], mod, func, scope);
+        splatOperands(av, bv);
+        if (av->getType()->isIntOrIntVectorTy()) { // integer
             switch (statement->value[0]) {
-                case '+':
-                    return Builder.CreateAdd(
-                        av, 
-                        compileValueExpression(statement->statements[1], mod, func, scope),
-                        "addtmp"
-                    );
-                case '-':
-                    return Builder.CreateSub(
-                        av, 
-                        compileValueExpression(statement->statements[1], mod, func, scope),
-                        "subtmp"
-                    );
-                case '*':
-                    return Builder.CreateMul(
-                        av, 
-                        compileValueExpression(statement->statements[1], mod, func, scope),
-                        "multmp"
-                    );
-                case '/':
-                    return Builder.CreateSDiv(
-                        av, 
-                        compileValueExpression(statement->statements[1], mod, func, scope),
-                        "divtmp"
-                    );
-                default:
-                    std::cout << "NO OPERATOR\n";
+                case '+': return Builder.CreateAdd(av, bv, "addtmp");
+                case '-': return Builder.CreateSub(av, bv, "subtmp");
+                case '*': return Builder.CreateMul(av, bv, "multmp");
+                case '/': return Builder.CreateSDiv(av, bv, "divtmp");
             }
         } else { // floating point
             switch (statement->value[0]) {
-                case '+':
-                    return Builder.CreateFAdd(
-                        av, 
-                        compileValueExpression(statement->statements[1], mod, func, scope),
-                        "faddtmp"
-                    );
-                case '-':
-                    return Builder.CreateFSub(
-                        av, 
-                        compileValueExpression(statement->statements[1], mod, func, scope),
-                        "fsubtmp"
-                    );
-                case '*':
-                    return Builder.CreateFMul(
-                        av, 
-                        compileValueExpression(statement->statements[1], mod, func, scope),
-                        "fmultmp"
-                    );
-                case '/':
-                    return Builder.CreateFDiv(
-                        av, 
-                        compileValueExpression(statement->statements[1], mod, func, scope),
-                        "fdivtmp"
-                    );
-                default:
-                    std::cout << "NO OPERATOR\n";
+                case '+': return Builder.CreateFAdd(av, bv, "faddtmp");
+                case '-': return Builder.CreateFSub(av, bv, "fsubtmp");
+                case '*': return Builder.CreateFMul(av, bv, "fmultmp");
+                case '/': return Builder.CreateFDiv(av, bv, "fdivtmp");
             }
         }
+        throw std::runtime_error("Unknown operator " + std::string(statement->value));
     }
 
     llvm::Value* compileLogicExpr(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope) {
         llvm::Value* av = compileValueExpression(statement->statements[0], mod, func, scope);
+        llvm::Value* bv = compileValueExpression(statement->statements[1], mod, func, scope);
+        splatOperands(av, bv);
 
-        if (av->getType()->isIntegerTy()) { // integer
+        if (av->getType()->isIntOrIntVectorTy()) { // integer, vectors are compared lane by lane
             if (statement->value.size() == 1) {
                 switch (statement->value[0]) {
-                    case '<':
-                        return Builder.CreateICmpSLT(
-                            av, 
-                            compileValueExpression(statement->statements[1], mod, func, scope), 
-                            "lttmp"
-                        );
-                    case '>':
-                        return Builder.CreateICmpSGT(
-                            av, 
-                            compileValueExpression(statement->statements[1], mod, func, scope), 
-                            "gttmp"
-                        );
+                    case '<': return Builder.CreateICmpSLT(av, bv, "lttmp");
+                    case '>': return Builder.CreateICmpSGT(av, bv, "gttmp");
                 }
             } else {
                 switch(statement->value[0]) {
-                    case '<':
-                        return Builder.CreateICmpSLE(
-                            av, 
-                            compileValueExpression(statement->statements[1], mod, func, scope), 
-                            "letmp"
-                        );
-                    case '>':
-                        return Builder.CreateICmpSGE(
-                            av, 
-                            compileValueExpression(statement->statements[1], mod, func, scope), 
-                            "getmp"
-                        );
-                    case '!':
-                        return Builder.CreateICmpNE(
-                            av, 
-                            compileValueExpression(statement->statements[1], mod, func, scope), 
-                            "netmp"
-                        );
-                    case '=':
-                        return Builder.CreateICmpEQ(
-                            av, 
-                            compileValueExpression(statement->statements[1], mod, func, scope), 
-                            "eqtmp"
-                        );
-                        
+                    case '<': return Builder.CreateICmpSLE(av, bv, "letmp");
+                    case '>': return Builder.CreateICmpSGE(av, bv, "getmp");
+                    case '!': return Builder.CreateICmpNE(av, bv, "netmp");
+                    case '=': return Builder.CreateICmpEQ(av, bv, "eqtmp");
                 }
             }
         } else { // double
             if (statement->value.size() == 1) {
                 switch (statement->value[0]) {
-                    case '<':
-                        return Builder.CreateFCmpOLT(
-                            av, 
-                            compileValueExpression(statement->statements[1], mod, func, scope), 
-                            "flttmp"
-                        );
-                    case '>':
-                        return Builder.CreateFCmpOGT(
-                            av, 
-                            compileValueExpression(statement->statements[1], mod, func, scope), 
-                            "fgttmp"
-                        );
+                    case '<': return Builder.CreateFCmpOLT(av, bv, "flttmp");
+                    case '>': return Builder.CreateFCmpOGT(av, bv, "fgttmp");
                 }
             } else {
                 switch(statement->value[0]) {
-                    case '<':
-                        return Builder.CreateFCmpOLE(
-                            av, 
-                            compileValueExpression(statement->statements[1], mod, func, scope), 
-                            "fletmp"
-                        );
-                    case '>':
-                        return Builder.CreateFCmpOGE(
-                            av, 
-                            compileValueExpression(statement->statements[1], mod, func, scope), 
-                            "fgetmp"
-                        );
-                    case '!':
-                        return Builder.CreateFCmpONE(
-                            av, 
-                            compileValueExpression(statement->statements[1], mod, func, scope), 
-                            "fnetmp"
-                        );
-                    case '=':
-                        return Builder.CreateFCmpOEQ(
-                            av, 
-                            compileValueExpression(statement->statements[1], mod, func, scope), 
-                            "feqtmp"
-                        );
-                        
+                    case '<': return Builder.CreateFCmpOLE(av, bv, "fletmp");
+                    case '>': return Builder.CreateFCmpOGE(av, bv, "fgetmp");
+                    case '!': return Builder.CreateFCmpONE(av, bv, "fnetmp");
+                    case '=': return Builder.CreateFCmpOEQ(av, bv, "feqtmp");
                 }
             }
         }
+        throw std::runtime_error("Unknown comparison " + std::string(statement->value));
+    }
+
+    // converts a scalar or every lane of a vector of the same number of lanes as t
+    llvm::Value* compileLaneCast(llvm::Value* v, llvm::Type* t) {
+        llvm::Type* from = v->getType()->getScalarType();
+        llvm::Type* to = t->getScalarType();
+        if (from->isIntegerTy() && to->isIntegerTy()) return Builder.CreateIntCast(v, t, true);
+        if (from->isFloatingPointTy() && to->isIntegerTy()) return Builder.CreateFPToSI(v, t);
+        if (from->isIntegerTy() && to->isFloatingPointTy()) return Builder.CreateSIToFP(v, t);
+        if (v->getType() != t) return Builder.CreateBitCast(v, t, "casttmp");
+        return v;
+    }
+
+    // converts every lane of a vector, a scalar is converted to the element type and put into every lane
+    llvm::Value* compileVectorCast(llvm::Value* v, llvm::FixedVectorType* vt) {
+        llvm::Type* t = v->getType()->isVectorTy() ? static_cast<llvm::Type*>(vt) : vt->getElementType();
+        if (t == vt && llvm::cast<llvm::FixedVectorType>(v->getType())->getNumElements() != vt->getNumElements()) {
+            throw std::runtime_error("Vector casts have to keep the number of lanes");
+        }
+
+        v = compileLaneCast(v, t);
+        if (!v->getType()->isVectorTy()) {
+            v = Builder.CreateVectorSplat(vt->getNumElements(), v, "splattmp");
+        }
+        return v;
     }
 
     llvm::Value* compileTypeCast(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope) {
         llvm::Value* v = compileValueExpression(statement->statements[0], mod, func, scope);
+        if (llvm::FixedVectorType* vt = llvm::dyn_cast<llvm::FixedVectorType>(compileType(statement->value))) {
+            return compileVectorCast(v, vt);
+        }
         // ty<int> -> ty1<int>
         if ((statement->value == "int" || statement->value == "bool" || statement->value == "long" || statement->value == "char") && v->getType()->isIntegerTy()) {
             return Builder.CreateIntCast(v, compileType(statement->value), true);
@@ -456,153 +820,172 @@ namespace compiler {
         }
 
         // bitcast for all other types
-        return Builder.CreateBitCast(compileValueExpression(statement->statements[0], mod, func, scope), compileType(statement->value), "casttmp");
+        return Builder.CreateBitCast(v, compileType(statement->value), "casttmp");
     }
 
-    llvm::Value* compileArrayCall(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope) {
-        llvm::AllocaInst* alloca = static_cast<llvm::AllocaInst*>(scope->namedValues[statement->statements[0]->value]);
-        std::vector<llvm::Value*> indx;
-                indx.emplace_back(llvm::ConstantInt::get(llvmContext, llvm::APInt(32, 0, true)));
-        indx.emplace_back(compileValueExpression(statement->statements[1], mod, func, scope));
-        llvm::Value* tmp = Builder.CreateInBoundsGEP(alloca->getAllocatedType(), alloca, indx, "geptmp");
-        return Builder.CreateLoad(tmp->getType(), tmp, "actmp");
-    }
-
-    llvm::Value* compileArrayDef(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope) {
-        // ! -------
-        // !  W.I.P.
-        // ! -------
-        // TODO: Fix type checking (not all values are always constant)
-        // TODO: Allow empty arrays (and figure out hot to get their type)
-        // TODO: Add memory copy to instantiate this array instead of returning global pointer
-
-        llvm::ArrayType* at;
-        llvm::Constant* ca;
-        if (statement->statements.size() > 0) {
-            at = llvm::ArrayType::get(compileValueExpression(statement->statements[0], mod, func, scope)->getType(), statement->statements.size());
-        }
-
-        if (statement->statements.size() > 0) {
-            std::vector<llvm::Constant*> vals;
-            for (auto s : statement->statements) {
-                llvm::Value* tv = compileValueExpression(s, mod, func, scope);
-                if (tv->getType()->isIntegerTy()) {
-                    vals.emplace_back((llvm::ConstantInt*) tv);
-                } else if (tv->getType()->isDoubleTy()) { 
-                    vals.emplace_back((llvm::ConstantFP*) tv);
-                }
-            }
+    // address of an array element, with -fbounds-checks the index is checked unless it is known to fit
+    llvm::Value* compileArrayElement(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope) {
+        parser::Statement* array = statement->statements[0];
+        llvm::AllocaInst* alloca = llvm::dyn_cast<llvm::AllocaInst>(slots[array->slot]);
+        llvm::ArrayType* at = alloca != nullptr ? llvm::dyn_cast<llvm::ArrayType>(alloca->getAllocatedType()) : nullptr;
+        if (at == nullptr) throw std::runtime_error(std::string(array->value) + " is not an array");
+
+        llvm::Value* index = compileValueExpression(statement->statements[1], mod, func, scope);
+        if (!index->getType()->isIntegerTy()) throw std::runtime_error("Index of " + std::string(array->value) + " is not an integer");
+        index = Builder.CreateSExtOrTrunc(index, llvm::Type::getInt64Ty(llvmContext));
+        uint64_t length = at->getNumElements();
+
+        // only literals are rejected, other indices fold to constants depending on the options
+        llvm::ConstantInt* c = llvm::dyn_cast<llvm::ConstantInt>(index);
+        bool fits = c != nullptr && c->getSExtValue() >= 0 && (uint64_t)c->getSExtValue() < length;
+        parser::StatementType indexType = statement->statements[1]->type;
+        if (!fits && (indexType == parser::StatementType::INTEGER_LITERAL || indexType == parser::StatementType::LONG_LITERAL)) {
+            throw std::runtime_error("Index " + std::to_string(c->getSExtValue()) + " is out of bounds of " + std::string(array->value));
+        }
 
-            ca = llvm::ConstantArray::get(at, *(new llvm::ArrayRef(vals)));
-            return new llvm::GlobalVariable(*mod, at, true, llvm::GlobalValue::LinkageTypes::ExternalLinkage, ca, "__const.arr");
+        if (boundsChecks && !fits && !isIndexInBounds(statement->statements[1], length)) {
+            // negative indices are huge when compared unsigned
+            llvm::Value* inBounds = Builder.CreateICmpULT(index, llvm::ConstantInt::get(index->getType(), length), "inbounds");
+            llvm::BasicBlock* failBB = llvm::BasicBlock::Create(llvmContext, "bounds.fail", func);
+            llvm::BasicBlock* okBB = llvm::BasicBlock::Create(llvmContext, "bounds.ok", func);
+            Builder.CreateCondBr(inBounds, okBB, failBB, llvm::MDBuilder(llvmContext).createBranchWeights(1 << 20, 1));
+
+            Builder.SetInsertPoint(failBB);
+            Builder.CreateIntrinsic(llvm::Intrinsic::trap, {}, {});
+            Builder.CreateUnreachable();
+            Builder.SetInsertPoint(okBB);
         }
-        
-        return ca;
+
+        llvm::Value* indices[] = { llvm::ConstantInt::get(index->getType(), 0), index };
+        return Builder.CreateInBoundsGEP(at, alloca, indices, "geptmp");
     }
 
-    llvm::Value* compileString(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope) {
-        return Builder.CreateGlobalStringPtr(llvm::StringRef(statement->value), "__const.str");
+    llvm::Value* compileArrayCall(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope) {
+        llvm::Value* element = compileArrayElement(statement, mod, func, scope);
+        llvm::Type* type = llvm::cast<llvm::GetElementPtrInst>(element)->getResultElementType();
+        return Builder.CreateLoad(type, element, "actmp");
     }
 
-    llvm::Value* compileValueExpression(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope) {
-        if (statement->type == parser::StatementType::INTEGER_LITERAL) {
-            return llvm::ConstantInt::get(llvmContext, llvm::APInt(32, std::stoi(statement->value)));
-        }
-        if (statement->type == parser::StatementType::LONG_LITERAL) {
-            return llvm::ConstantInt::get(llvmContext, llvm::APInt(64, std::stol(statement->value)));
-        }
-        if (statement->type == parser::StatementType::CHAR_LITERAL) {
-            return llvm::ConstantInt::get(llvmContext, llvm::APInt(8, statement->value[0]));
-        }
-        if (statement->type == parser::StatementType::BOOLEAN_LITERAL) {
-            return llvm::ConstantInt::get(llvmContext, llvm::APInt(1, (statement->value == "true" ? 1 : 0)));
-        }
-        if (statement->type == parser::StatementType::DOUBLE_LITERAL) {
-            return llvm::ConstantFP::get(llvmContext, llvm::APFloat(std::stod(statement->value)));
-        }
-        if (statement->type == parser::StatementType::VARIABLE_CALL) {
-            return compileVariableCall(statement, mod, func, scope);
-        }
-        if (statement->type == parser::StatementType::FUNCTION_CALL) {
-            return compileFunctionCall(statement, mod, func, scope);
-        }
-        if (statement->type == parser::StatementType::MATH) {
-            return compileMath(statement, mod, func, scope);
-        }
-        if (statement->type == parser::StatementType::LOGIC_EXPRESSION) {
-            return compileLogicExpr(statement, mod, func, scope);
-        }
-        if (statement->type == parser::StatementType::TYPE_CAST) {
-            return compileTypeCast(statement, mod, func, scope);
-        }
-        if (statement->type == parser::StatementType::STRING) {
-            return compileString(statement, mod, func, scope);
-        }
-        if (statement->type == parser::StatementType::GET_ALLOCA) {
-            return compileGetAlloca(statement, mod, func, scope);
-        }
-        if (statement->type == parser::StatementType::ARRAY_DEFINITION) {
-            return compileArrayDef(statement, mod, func, scope);
-        }
-        if (statement->type == parser::StatementType::ARRAY_CALL) {
-            return compileArrayCall(statement, mod, func, scope);
-        }
+    llvm::Value* compileArrayAssignment(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope) {
+        llvm::Value* element = compileArrayElement(statement, mod, func, scope);
+        llvm::Value* val = compileValueExpression(statement->statements[2], mod, func, scope);
+        Builder.CreateStore(val, element);
+        return val;
+    }
 
-        // variable definition
-        if (statement->type == parser::StatementType::VARIABLE_DEFINITON) {
-            return compileVariableDefinition(statement, mod, func, scope);
+    llvm::Value* compileArrayDef(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope) {
+        // TODO: Allow empty arrays (and figure out hot to get their type)
+        if (statement->statements.empty()) {
+            throw std::runtime_error("Empty arrays are not supported");
         }
 
-        if (statement->type == parser::StatementType::VARIABLE_ASSIGNMENT) {
-            return compileVariableAssignment(statement, mod, func, scope);
+        // the element type is the type of the first value
+        std::vector<llvm::Value*> vals;
+        for (auto s : statement->statements) {
+            vals.emplace_back(compileValueExpression(s, mod, func, scope));
         }
+        llvm::ArrayType* at = llvm::ArrayType::get(vals[0]->getType(), vals.size());
 
-    }
-
-
-    llvm::Value* compileExpression(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope) {
-        // code block
-        if (statement->type == parser::StatementType::CODE_BLOCK) {
-            for (parser::Statement* s : statement->statements) {
-                compileExpression(s, mod, func, scope);
-            }
+        // constant arrays are a single value, others are built element by element
+        std::vector<llvm::Constant*> constants;
+        for (llvm::Value* v : vals) {
+            if (llvm::Constant* c = llvm::dyn_cast<llvm::Constant>(v)) constants.emplace_back(c);
         }
-
-        // return
-        if (statement->type == parser::StatementType::RETURN) {
-            compileReturn(statement, mod, func, scope);
-            return nullptr;
+        if (constants.size() == vals.size()) {
+            return llvm::ConstantArray::get(at, constants);
         }
 
-        // if statement
-        if (statement->type == parser::StatementType::IF || statement->type == parser::StatementType::IFELSE) {
-            compileIfStatement(statement, mod, func, scope);
-            return nullptr;
+        llvm::Value* array = llvm::UndefValue::get(at);
+        for (unsigned i = 0; i < vals.size(); i++) {
+            array = Builder.CreateInsertValue(array, vals[i], i, "arrtmp");
         }
+        return array;
+    }
 
-        // variable definition
-        if (statement->type == parser::StatementType::VARIABLE_DEFINITON) {
-            compileVariableDefinition(statement, mod, func, scope);
-            return nullptr;
-        }
+    llvm::Value* compileString(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope) {
+        return Builder.CreateGlobalStringPtr(llvm::StringRef(statement->value), "__const.str");
+    }
 
-        if (statement->type == parser::StatementType::FUNCTION_CALL) {
-            return compileFunctionCall(statement, mod, func, scope);
+    // nullptr for statements that are not literals
+    llvm::Constant* compileLiteral(parser::Statement* statement) {
+        switch (statement->type) {
+            case parser::StatementType::INTEGER_LITERAL:
+                return llvm::ConstantInt::get(llvmContext, llvm::APInt(32, std::stoi(std::string(statement->value))));
+            case parser::StatementType::LONG_LITERAL:
+                return llvm::ConstantInt::get(llvmContext, llvm::APInt(64, std::stol(std::string(statement->value))));
+            case parser::StatementType::CHAR_LITERAL:
+                return llvm::ConstantInt::get(llvmContext, llvm::APInt(8, statement->value[0]));
+            case parser::StatementType::BOOLEAN_LITERAL:
+                return llvm::ConstantInt::get(llvmContext, llvm::APInt(1, (statement->value == "true" ? 1 : 0)));
+            case parser::StatementType::DOUBLE_LITERAL:
+                return llvm::ConstantFP::get(llvmContext, llvm::APFloat(std::stod(std::string(statement->value))));
+            default:
+                return nullptr;
         }
+    }
 
-        if (statement->type == parser::StatementType::VARIABLE_ASSIGNMENT) {
-            return compileVariableAssignment(statement, mod, func, scope);
+    // lowers every value statement once, asking again for the same statement returns the cached value
+    llvm::Value* compileValueExpression(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope) {
+        auto cached = loweredValues.find(statement);
+        if (cached != loweredValues.end()) return cached->second;
+
+        llvm::Value* value;
+        switch (statement->type) {
+            case parser::StatementType::INTEGER_LITERAL:
+            case parser::StatementType::LONG_LITERAL:
+            case parser::StatementType::CHAR_LITERAL:
+            case parser::StatementType::BOOLEAN_LITERAL:
+            case parser::StatementType::DOUBLE_LITERAL:
+                value = compileLiteral(statement);
+                break;
+            case parser::StatementType::VARIABLE_CALL:       value = compileVariableCall(statement, mod, func, scope); break;
+            case parser::StatementType::FUNCTION_CALL:       value = compileFunctionCall(statement, mod, func, scope); break;
+            case parser::StatementType::MATH:                value = compileMath(statement, mod, func, scope); break;
+            case parser::StatementType::LOGIC_EXPRESSION:    value = compileLogicExpr(statement, mod, func, scope); break;
+            case parser::StatementType::TYPE_CAST:           value = compileTypeCast(statement, mod, func, scope); break;
+            case parser::StatementType::STRING:              value = compileString(statement, mod, func, scope); break;
+            case parser::StatementType::GET_ALLOCA:          value = compileGetAlloca(statement, mod, func, scope); break;
+            case parser::StatementType::ARRAY_DEFINITION:    value = compileArrayDef(statement, mod, func, scope); break;
+            case parser::StatementType::ARRAY_CALL:          value = compileArrayCall(statement, mod, func, scope); break;
+            case parser::StatementType::ARRAY_ASSIGNMENT:    value = compileArrayAssignment(statement, mod, func, scope); break;
+            case parser::StatementType::VARIABLE_DEFINITON:  value = compileVariableDefinition(statement, mod, func, scope); break;
+            case parser::StatementType::VARIABLE_ASSIGNMENT: value = compileVariableAssignment(statement, mod, func, scope); break;
+            default:
+                throw std::runtime_error("Statement " + std::to_string(statement->type) + " has no value");
         }
 
-        if (statement->type == parser::StatementType::FOR_LOOP) {
-            return compileForStatement(statement, mod, func, scope);
-        }
+        loweredValues[statement] = value;
+        return value;
+    }
 
-        return nullptr;
+
+    llvm::Value* compileExpression(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope) {
+        switch (statement->type) {
+            case parser::StatementType::CODE_BLOCK:
+                for (parser::Statement* s : statement->statements) {
+                    compileExpression(s, mod, func, scope);
+                }
+                return nullptr;
+            case parser::StatementType::RETURN:
+                compileReturn(statement, mod, func, scope);
+                return nullptr;
+            case parser::StatementType::IF:
+            case parser::StatementType::IFELSE:
+                return compileIfStatement(statement, mod, func, scope);
+            case parser::StatementType::FOR_LOOP:
+                return compileForStatement(statement, mod, func, scope);
+            case parser::StatementType::VARIABLE_DEFINITON:
+            case parser::StatementType::VARIABLE_ASSIGNMENT:
+            case parser::StatementType::ARRAY_ASSIGNMENT:
+            case parser::StatementType::FUNCTION_CALL:
+                return compileValueExpression(statement, mod, func, scope);
+            default:
+                return nullptr;
+        }
     }
 
-    llvm::Type* compileType(const std::string& type) {
-        std::string tn = type;
+    llvm::Type* compileType(std::string_view type) {
+        std::string tn(type);
         bool isPointer = false;
         bool isArray = false;
         int arrlen = -1;
@@ -631,6 +1014,10 @@ namespace compiler {
         else if (tn == "char") rt = llvm::Type::getInt8Ty(llvmContext);
         else if (tn == "bool") rt = llvm::Type::getInt1Ty(llvmContext);
         else if (tn == "double") rt = llvm::Type::getDoubleTy(llvmContext);
+        else if (tn.rfind("vec<", 0) == 0) { // vec<element type,lanes>
+            size_t comma = tn.rfind(',');
+            rt = llvm::FixedVectorType::get(compileType(tn.substr(4, comma - 4)), std::atoi(tn.substr(comma + 1).c_str()));
+        }
         else if (tn == "void") rt = llvm::Type::getVoidTy(llvmContext);
 
         if (isPointer) {
@@ -2,11 +2,17 @@
 
 #include <iostream>
 #include <vector>
+#include <algorithm>
+#include <set>
+#include <unordered_map>
 #include <fstream>
+#include <future>
+#include <optional>
 
 #include "../parser/Parser.hpp"
 #include "../tokenizer/Tokenizer.hpp"
 #include "../parser/Statements.hpp"
+#include "Resolver.hpp"
 
 // llvm imports
 #include "llvm/IR/Value.h"
@@ -14,42 +20,63 @@
 #include "llvm/IR/Function.h"
 #include "llvm/IR/BasicBlock.h"
 #include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/MDBuilder.h"
 #include "llvm/IR/PassManager.h"
 #include "llvm/IR/Verifier.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
 
 #include <filesystem>
 namespace fs = std::filesystem;
 
 namespace compiler {
 
-    llvm::Module* compileModule(std::vector<parser::Statement*> module, const std::string& name, const std::string& path);
+    llvm::Module* compileModule(std::vector<parser::Statement*> module, const std::string& name, const std::vector<std::string>& imports, parser::Arena& moduleArena, const parser::CompileOptions& options);
 
     std::string base_name(std::string const & path);
+    void declareFunctions(llvm::Module* from, llvm::Module* mod);
 
-    llvm::Module* compileImport(parser::Statement* statement, llvm::Module* mod, const std::string& path);
-    llvm::Function* compileFunction(parser::Statement* statement, llvm::Module* mod);
+    std::string writeBitcode(llvm::Module* mod);
+    std::string writeDeclarations(llvm::Module* from);
+    void declareImport(const std::string& declarations, llvm::Module* mod);
+    llvm::Function* compileFunction(parser::FunctionDefinition* statement, FunctionSlots& resolved, llvm::Module* mod, const parser::CompileOptions& options);
     llvm::Value* compileExpression(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope);
     llvm::Value* compileValueExpression(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope);
     llvm::ReturnInst* compileReturn(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope);
     llvm::Value* compileVariableDefinition(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope);
     llvm::Value* compileVariableCall(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope);
+    llvm::Constant* compileLiteral(parser::Statement* statement);
     llvm::Value* compileString(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope);
     llvm::Value* compileArrayDef(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope);
+    llvm::Value* compileArrayElement(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope);
+    llvm::Value* compileArrayAssignment(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope);
     llvm::Value* compileArrayCall(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope);
     llvm::Value* compileVariableAssignment(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope);
     llvm::Value* compileFunctionCall(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope);
     llvm::Value* compileMath(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope);
     llvm::Value* compileIfStatement(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope);
     llvm::Value* compileForStatement(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope);
+    llvm::Value* compileLaneCast(llvm::Value* v, llvm::Type* t);
+    llvm::Value* compileVectorCast(llvm::Value* v, llvm::FixedVectorType* vt);
     llvm::Value* compileTypeCast(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope);
     llvm::Value* compileLogicExpr(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope);
     llvm::Value* compileGetAlloca(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope);
 
-    llvm::AllocaInst* allocateEntry(llvm::Function* func, llvm::Type* t, const std::string& name);
+    llvm::AllocaInst* allocateEntry(llvm::Function* func, llvm::Type* t, std::string_view name);
+    llvm::MDNode* compileLoopHints(parser::Statement* statement);
+    void forgetLowered(parser::Statement* statement);
+    void collectAssignedSlots(parser::Statement* statement, std::vector<int>& assigned);
+    bool isSSALocal(int slot, llvm::Type* type);
+    void setSlot(parser::Scope* scope, int slot, llvm::Value* value);
+    void restoreScope(parser::Scope* scope);
+    void leaveScope(parser::Scope* scope);
+    void mergeSSAValues(parser::Scope* scope, const std::vector<std::pair<parser::Scope*, llvm::BasicBlock*>>& branches);
 
+    llvm::Value* compileVectorBuiltin(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope);
+    void splatOperands(llvm::Value*& a, llvm::Value*& b);
     llvm::Function* compileIntrinsic(parser::Statement* statement, llvm::Module* mod, llvm::Function* func, parser::Scope* scope);
     llvm::Function* createFDeclaration(llvm::Module* mod, const std::string& name, llvm::Type* rt, std::vector<llvm::Type*> at, bool varargs);
 
-    llvm::Type* compileType(const std::string& type);
+    llvm::Type* compileType(std::string_view type);
 
 }
\ No newline at end of file
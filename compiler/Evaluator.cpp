@@ -0,0 +1,301 @@
+#include "Evaluator.hpp"
+#include "Compiler.hpp"
+
+namespace compiler {
+
+    namespace {
+
+        // limits of one evaluated call, calls that run longer are compiled normally
+        const long maxSteps = 1 << 20;
+        const int maxDepth = 256;
+
+        bool isScalarType(std::string_view type) {
+            return type == "int" || type == "long" || type == "char" || type == "bool" || type == "double";
+        }
+
+        bool isValue(llvm::Constant* c) {
+            return llvm::isa<llvm::ConstantInt>(c) || llvm::isa<llvm::ConstantFP>(c);
+        }
+
+    }
+
+    void Evaluator::addFunction(parser::FunctionDefinition* function, int slotCount) {
+        functions[function->symbol] = {function, slotCount, true, false};
+    }
+
+    void Evaluator::analyze() {
+        for (auto& f : functions) {
+            parser::FunctionDefinition* definition = f.second.definition;
+            f.second.pure = isScalarType(definition->dataType);
+            for (auto& arg : definition->args) {
+                f.second.pure = f.second.pure && isScalarType(arg.type);
+            }
+        }
+
+        // functions start out pure, the ones calling impure code are dropped until nothing changes
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (auto& f : functions) {
+                if (!f.second.pure) continue;
+                for (parser::Statement* s : f.second.definition->statements) {
+                    if (isPureStatement(s)) continue;
+                    f.second.pure = false;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    bool Evaluator::isPure(int symbol) const {
+        auto it = functions.find(symbol);
+        return it != functions.end() && it->second.pure;
+    }
+
+    bool Evaluator::isConst(int symbol) const {
+        auto it = functions.find(symbol);
+        return it != functions.end() && it->second.definition->isConst;
+    }
+
+    bool Evaluator::isPureStatement(parser::Statement* statement) const {
+        switch (statement->type) {
+            case parser::StatementType::STRING:
+            case parser::StatementType::GET_ALLOCA:
+            case parser::StatementType::ARRAY_DEFINITION:
+            case parser::StatementType::ARRAY_CALL:
+            case parser::StatementType::ARRAY_ASSIGNMENT:
+                return false;
+            case parser::StatementType::VARIABLE_DEFINITON:
+                if (!isScalarType(llvm::cast<parser::Definition>(statement)->dataType)) return false;
+                break;
+            case parser::StatementType::TYPE_CAST:
+                if (!isScalarType(statement->value)) return false;
+                break;
+            case parser::StatementType::FUNCTION_CALL:
+                if (!isPure(statement->symbol)) return false;
+                break;
+            default:
+                break;
+        }
+        for (parser::Statement* s : statement->statements) {
+            if (!isPureStatement(s)) return false;
+        }
+        return true;
+    }
+
+    llvm::Constant* Evaluator::evaluateCall(int symbol, llvm::ArrayRef<llvm::Value*> args) {
+        auto it = functions.find(symbol);
+        if (it == functions.end() || !it->second.pure) return nullptr;
+
+        // const functions have to be evaluated, other ones are given up on once a call ran out of limits
+        Function& function = it->second;
+        if (function.exhausted && !function.definition->isConst) return nullptr;
+
+        std::vector<llvm::Constant*> values;
+        for (llvm::Value* arg : args) {
+            llvm::Constant* c = llvm::dyn_cast<llvm::Constant>(arg);
+            if (c == nullptr || !isValue(c)) return nullptr;
+            values.push_back(c);
+        }
+
+        steps = 0;
+        depth = 0;
+        try {
+            return call(function, values);
+        } catch (Unevaluable& e) {
+            // failed calls are remembered, so other calls with the same arguments do not run again
+            results.emplace(std::make_pair(symbol, std::move(values)), nullptr);
+            if (e.exhausted) function.exhausted = true;
+            return nullptr;
+        }
+    }
+
+    llvm::Constant* Evaluator::call(const Function& function, std::vector<llvm::Constant*> args) {
+        parser::FunctionDefinition* definition = function.definition;
+        if (args.size() != definition->args.size()) throw Unevaluable();
+
+        auto key = std::make_pair(definition->symbol, std::move(args));
+        auto cached = results.find(key);
+        if (cached != results.end()) {
+            if (cached->second == nullptr) throw Unevaluable();
+            return cached->second;
+        }
+
+        if (++depth > maxDepth) throw Unevaluable{true};
+
+        // arguments take the first slots
+        Frame frame;
+        frame.slots.resize(function.slotCount, nullptr);
+        for (size_t i = 0; i < key.second.size(); i++) {
+            if (key.second[i]->getType() != compileType(definition->args[i].type)) throw Unevaluable();
+            frame.slots[i] = key.second[i];
+        }
+
+        for (parser::Statement* s : definition->statements) {
+            if (execute(s, frame) == Flow::RETURN) break;
+        }
+        depth--;
+
+        if (frame.result == nullptr || frame.result->getType() != compileType(definition->dataType)) throw Unevaluable();
+
+        results.emplace(std::move(key), frame.result);
+        return frame.result;
+    }
+
+    Evaluator::Flow Evaluator::execute(parser::Statement* statement, Frame& frame) {
+        if (++steps > maxSteps) throw Unevaluable{true};
+
+        switch (statement->type) {
+            case parser::StatementType::CODE_BLOCK:
+                for (parser::Statement* s : statement->statements) {
+                    if (execute(s, frame) == Flow::RETURN) return Flow::RETURN;
+                }
+                return Flow::NEXT;
+            case parser::StatementType::RETURN:
+                if (statement->statements.empty()) throw Unevaluable();
+                frame.result = operand(statement->statements[0], frame);
+                return Flow::RETURN;
+            case parser::StatementType::IF:
+            case parser::StatementType::IFELSE:
+                if (isTrue(operand(statement->statements[0], frame))) {
+                    return execute(statement->statements[1], frame);
+                }
+                if (statement->type == parser::StatementType::IFELSE) {
+                    return execute(statement->statements[2], frame);
+                }
+                return Flow::NEXT;
+            case parser::StatementType::FOR_LOOP:
+                evaluate(statement->statements[0], frame);
+                while (isTrue(operand(statement->statements[1], frame))) {
+                    if (execute(statement->statements[3], frame) == Flow::RETURN) return Flow::RETURN;
+                    evaluate(statement->statements[2], frame);
+                }
+                return Flow::NEXT;
+            default:
+                evaluate(statement, frame);
+                return Flow::NEXT;
+        }
+    }
+
+    bool Evaluator::isTrue(llvm::Constant* condition) {
+        llvm::ConstantInt* c = llvm::dyn_cast<llvm::ConstantInt>(condition);
+        if (c == nullptr || c->getBitWidth() != 1) throw Unevaluable();
+        return !c->isZero();
+    }
+
+    llvm::Constant* Evaluator::operand(parser::Statement* statement, Frame& frame) {
+        llvm::Constant* value = evaluate(statement, frame);
+        if (value == nullptr) throw Unevaluable();
+        return value;
+    }
+
+    // nullptr only for a variable definition without a value
+    llvm::Constant* Evaluator::evaluate(parser::Statement* statement, Frame& frame) {
+        if (++steps > maxSteps) throw Unevaluable{true};
+
+        if (llvm::Constant* literal = compileLiteral(statement)) return literal;
+
+        switch (statement->type) {
+            case parser::StatementType::VARIABLE_CALL: {
+                llvm::Constant* value = frame.slots[statement->slot];
+                if (value == nullptr) throw Unevaluable(); // read before it was assigned
+                return value;
+            }
+            case parser::StatementType::VARIABLE_DEFINITON:
+                frame.slots[statement->slot] = statement->statements.empty() ? nullptr : operand(statement->statements[0], frame);
+                return frame.slots[statement->slot];
+            case parser::StatementType::VARIABLE_ASSIGNMENT:
+                frame.slots[statement->slot] = operand(statement->statements[0], frame);
+                return frame.slots[statement->slot];
+            case parser::StatementType::FUNCTION_CALL: {
+                std::vector<llvm::Constant*> args;
+                for (parser::Statement* s : statement->statements) {
+                    args.push_back(operand(s, frame));
+                }
+                auto it = functions.find(statement->symbol);
+                if (it == functions.end() || !it->second.pure) throw Unevaluable();
+                return call(it->second, std::move(args));
+            }
+            case parser::StatementType::MATH:
+                return evaluateMath(statement, operand(statement->statements[0], frame), operand(statement->statements[1], frame));
+            case parser::StatementType::LOGIC_EXPRESSION:
+                return evaluateLogic(statement, operand(statement->statements[0], frame), operand(statement->statements[1], frame));
+            case parser::StatementType::TYPE_CAST:
+                return evaluateTypeCast(statement, operand(statement->statements[0], frame));
+            default:
+                throw Unevaluable();
+        }
+    }
+
+    llvm::Constant* Evaluator::evaluateMath(parser::Statement* statement, llvm::Constant* a, llvm::Constant* b) {
+        if (a->getType() != b->getType()) throw Unevaluable();
+
+        bool isInteger = a->getType()->isIntegerTy();
+        unsigned opcode;
+        switch (statement->value[0]) {
+            case '+': opcode = isInteger ? llvm::Instruction::Add : llvm::Instruction::FAdd; break;
+            case '-': opcode = isInteger ? llvm::Instruction::Sub : llvm::Instruction::FSub; break;
+            case '*': opcode = isInteger ? llvm::Instruction::Mul : llvm::Instruction::FMul; break;
+            case '/':
+                // division by zero and overflowing division are left to run time
+                if (isInteger && (b->isNullValue() || (b->isAllOnesValue() && llvm::cast<llvm::ConstantInt>(a)->getValue().isMinSignedValue()))) {
+                    throw Unevaluable();
+                }
+                opcode = isInteger ? llvm::Instruction::SDiv : llvm::Instruction::FDiv;
+                break;
+            default:
+                throw Unevaluable();
+        }
+
+        llvm::Constant* result = llvm::ConstantExpr::get(opcode, a, b);
+        if (!isValue(result)) throw Unevaluable();
+        return result;
+    }
+
+    llvm::Constant* Evaluator::evaluateLogic(parser::Statement* statement, llvm::Constant* a, llvm::Constant* b) {
+        if (a->getType() != b->getType()) throw Unevaluable();
+
+        bool isInteger = a->getType()->isIntegerTy();
+        llvm::CmpInst::Predicate predicate;
+        if (statement->value.size() == 1) {
+            switch (statement->value[0]) {
+                case '<': predicate = isInteger ? llvm::CmpInst::ICMP_SLT : llvm::CmpInst::FCMP_OLT; break;
+                case '>': predicate = isInteger ? llvm::CmpInst::ICMP_SGT : llvm::CmpInst::FCMP_OGT; break;
+                default: throw Unevaluable();
+            }
+        } else {
+            switch (statement->value[0]) {
+                case '<': predicate = isInteger ? llvm::CmpInst::ICMP_SLE : llvm::CmpInst::FCMP_OLE; break;
+                case '>': predicate = isInteger ? llvm::CmpInst::ICMP_SGE : llvm::CmpInst::FCMP_OGE; break;
+                case '!': predicate = isInteger ? llvm::CmpInst::ICMP_NE : llvm::CmpInst::FCMP_ONE; break;
+                case '=': predicate = isInteger ? llvm::CmpInst::ICMP_EQ : llvm::CmpInst::FCMP_OEQ; break;
+                default: throw Unevaluable();
+            }
+        }
+
+        llvm::Constant* result = llvm::ConstantExpr::getCompare(predicate, a, b);
+        if (!isValue(result)) throw Unevaluable();
+        return result;
+    }
+
+    // the same conversions as compileTypeCast
+    llvm::Constant* Evaluator::evaluateTypeCast(parser::Statement* statement, llvm::Constant* v) {
+        std::string_view type = statement->value;
+        llvm::Type* t = compileType(type);
+
+        llvm::Constant* result = nullptr;
+        if ((type == "int" || type == "bool" || type == "long" || type == "char") && v->getType()->isIntegerTy()) {
+            result = llvm::ConstantExpr::getIntegerCast(v, t, true);
+        } else if (type == "int" && v->getType()->isDoubleTy()) {
+            result = llvm::ConstantExpr::getFPToSI(v, t);
+        } else if (type == "double" && v->getType()->isIntegerTy()) {
+            result = llvm::ConstantExpr::getSIToFP(v, t);
+        }
+
+        // out of range conversions are left to run time
+        if (result == nullptr || !isValue(result)) throw Unevaluable();
+        return result;
+    }
+
+}
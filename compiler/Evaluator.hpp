@@ -0,0 +1,64 @@
+#pragma once
+
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "../parser/Statements.hpp"
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/IR/Constants.h"
+
+namespace compiler {
+
+    // Evaluates calls of side effect free functions of one module at compile time
+    class Evaluator {
+        public:
+            // functions have to be resolved before they are added
+            void addFunction(parser::FunctionDefinition* function, int slotCount);
+            // finds the pure functions once every function of the module was added
+            void analyze();
+
+            bool isPure(int symbol) const;
+            bool isConst(int symbol) const;
+            // value of the call, nullptr if the callee is not pure or the call can not be evaluated
+            llvm::Constant* evaluateCall(int symbol, llvm::ArrayRef<llvm::Value*> args);
+
+        private:
+            struct Function {
+                parser::FunctionDefinition* definition;
+                int slotCount;
+                bool pure;
+                bool exhausted = false; // a call ran out of steps or depth, other calls are not tried again
+            };
+
+            // thrown when a call can not be evaluated, the call is compiled normally then
+            struct Unevaluable {
+                bool exhausted = false; // the limits were reached, the call might not end at all
+            };
+
+            // what ran last in a function body
+            enum class Flow { NEXT, RETURN };
+
+            struct Frame {
+                std::vector<llvm::Constant*> slots; // nullptr until a value is assigned
+                llvm::Constant* result = nullptr;
+            };
+
+            std::unordered_map<int, Function> functions;
+            std::map<std::pair<int, std::vector<llvm::Constant*>>, llvm::Constant*> results; // constants are unique, so pointers compare by value, nullptr for calls that failed
+            long steps = 0;
+            int depth = 0;
+
+            bool isPureStatement(parser::Statement* statement) const;
+            llvm::Constant* call(const Function& function, std::vector<llvm::Constant*> args);
+            Flow execute(parser::Statement* statement, Frame& frame);
+            bool isTrue(llvm::Constant* condition);
+            llvm::Constant* operand(parser::Statement* statement, Frame& frame);
+            llvm::Constant* evaluate(parser::Statement* statement, Frame& frame);
+            llvm::Constant* evaluateMath(parser::Statement* statement, llvm::Constant* a, llvm::Constant* b);
+            llvm::Constant* evaluateLogic(parser::Statement* statement, llvm::Constant* a, llvm::Constant* b);
+            llvm::Constant* evaluateTypeCast(parser::Statement* statement, llvm::Constant* v);
+    };
+
+}
@@ -0,0 +1,229 @@
+#include "ImportGraph.hpp"
+#include "Compiler.hpp"
+#include "Cache.hpp"
+#include "SourceManager.hpp"
+
+#include "llvm/Linker/Linker.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Transforms/IPO/Internalize.h"
+
+namespace compiler {
+
+    std::vector<ModuleNode*> buildImportGraph(const fs::path& mainFile, const parser::CompileOptions& options) {
+        ImportGraph graph;
+        addModuleNode(graph, mainFile, base_name(mainFile.string()), options);
+        return graph.order;
+    }
+
+    ModuleNode* addModuleNode(ImportGraph& graph, const fs::path& path, const std::string& name, const parser::CompileOptions& options) {
+        std::string id = fs::weakly_canonical(path).string();
+
+        // every module is loaded once, no matter how many times it is imported
+        auto it = graph.nodes.find(id);
+        if (it != graph.nodes.end()) {
+            if (std::find(graph.stack.begin(), graph.stack.end(), id) != graph.stack.end()) {
+                std::string cycle = "";
+                for (auto p = std::find(graph.stack.begin(), graph.stack.end(), id); p != graph.stack.end(); ++p) {
+                    cycle += *p + " -> ";
+                }
+                throw std::runtime_error("Import cycle: " + cycle + id);
+            }
+            return it->second;
+        }
+
+        ModuleNode* node = new ModuleNode();
+        node->path = path;
+        node->name = name;
+        node->code = loadSource(path);
+
+        graph.nodes[id] = node;
+        graph.stack.emplace_back(id);
+
+        // imports of a cached module are known without parsing it
+        std::vector<std::string> imports;
+        std::optional<std::vector<std::string>> cachedImports;
+        std::string srcKey;
+        if (!options.cacheDir.empty()) {
+            srcKey = sourceKey(node->code, options);
+            cachedImports = loadCachedImports(srcKey, options);
+        }
+
+        if (cachedImports.has_value()) {
+            imports = cachedImports.value();
+        } else {
+            parseModuleNode(node, options);
+            for (parser::Statement* s : node->AST) {
+                if (s->type == parser::StatementType::IMPORT) imports.emplace_back(s->value);
+            }
+            if (!options.cacheDir.empty()) storeCachedImports(srcKey, imports, options);
+        }
+
+        for (auto& import : imports) {
+            node->imports.emplace_back(addModuleNode(graph, path.parent_path()/import, base_name(import), options));
+        }
+
+        // a module has to be rebuilt when anything it imports changes
+        if (!options.cacheDir.empty()) {
+            std::string key = srcKey;
+            for (ModuleNode* import : node->imports) {
+                key += import->cacheKey;
+            }
+            node->cacheKey = hashString(key);
+        }
+
+        graph.stack.pop_back();
+        graph.order.emplace_back(node);
+
+        return node;
+    }
+
+    void parseModuleNode(ModuleNode* node, const parser::CompileOptions& options) {
+        if (options.verbose) {
+            for (auto& t : tokenizer::tokenize(node->code)) {
+                t.debug_print();
+            }
+            std::cout << "Compilation debug:\n";
+        }
+
+        // the parser pulls tokens from the source as it goes, no token list is kept
+        node->AST = parser::Parser(node->code, node->arena).parse();
+
+        if (options.verbose) {
+            std::cout << node->AST.size() << '\n';
+            for (auto s : node->AST) {
+                s->debug_print(0);
+            }
+        }
+    }
+
+    void compileImportedModule(ModuleNode* node, const parser::CompileOptions& options) {
+        std::string objName = node->name + ".o";
+
+        // reuse object and declarations if this exact module was compiled before
+        if (!node->cacheKey.empty()) {
+            std::optional<std::string> cached = loadCachedModule(node->cacheKey, objName, options);
+            if (cached.has_value()) {
+                if (options.verbose) std::cout << "\u001B[32mUsing cached module \u001B[36m" << node->path.string() << "\u001B[0m\n";
+                node->declarations = cached.value();
+                return;
+            }
+        }
+
+        if (options.verbose) std::cout << "\u001B[32mCompiling module \u001B[36m" << node->path.string() << "\u001B[0m\n";
+
+        if (node->AST.empty()) parseModuleNode(node, options);
+
+        std::vector<std::string> imports;
+        for (ModuleNode* import : node->imports) {
+            imports.emplace_back(import->declarations);
+        }
+
+        llvm::Module* im = compileModule(node->AST, node->name, imports, node->arena, options);
+        node->AST.clear();
+        node->arena.reset();
+
+        // exported declarations are taken before optimization can remove any of them
+        node->declarations = writeDeclarations(im);
+
+        // the jit needs the module itself, it is moved between contexts as bitcode
+        if (!options.emitObjects) {
+            node->bitcode = writeBitcode(im);
+            delete im;
+            return;
+        }
+
+        parser::Parser::saveCompilation(im, objName, options);
+        delete im;
+
+        if (!node->cacheKey.empty()) {
+            storeCachedModule(node->cacheKey, node->declarations, objName, options);
+        }
+    }
+
+    void compileImportsInParallel(const std::vector<ModuleNode*>& modules, const parser::CompileOptions& options) {
+        ModuleNode* mainModule = modules.back();
+
+        // a module is handed to the pool once everything it imports is compiled, no worker waits for another
+        std::mutex mutex;
+        std::map<ModuleNode*, size_t> pendingImports;
+        std::map<ModuleNode*, std::vector<ModuleNode*>> importers;
+        for (ModuleNode* node : modules) {
+            if (node == mainModule) continue;
+            pendingImports[node] = node->imports.size();
+            for (ModuleNode* import : node->imports) {
+                importers[import].emplace_back(node);
+            }
+        }
+
+        llvm::ThreadPool pool(llvm::hardware_concurrency());
+        std::vector<std::shared_future<void>> tasks;
+        std::function<void(ModuleNode*)> submit = [&](ModuleNode* node) {
+            tasks.emplace_back(pool.async([&, node]() {
+                compileImportedModule(node, options);
+
+                std::lock_guard<std::mutex> lock(mutex);
+                for (ModuleNode* importer : importers[node]) {
+                    if (--pendingImports[importer] == 0) submit(importer);
+                }
+            }));
+        };
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto& pending : pendingImports) {
+                if (pending.second == 0) submit(pending.first);
+            }
+        }
+        pool.wait();
+
+        // rethrows the first error, the importers of a failed module were never started
+        for (auto& task : tasks) task.get();
+    }
+
+    llvm::Module* compileImportGraph(const std::vector<ModuleNode*>& modules, const parser::CompileOptions& options) {
+        ModuleNode* mainModule = modules.back();
+
+        if (options.parallelImports) {
+            compileImportsInParallel(modules, options);
+        } else {
+            // imports always come before their importers
+            for (ModuleNode* node : modules) {
+                if (node != mainModule) compileImportedModule(node, options);
+            }
+        }
+
+        if (mainModule->AST.empty()) parseModuleNode(mainModule, options);
+
+        std::vector<std::string> imports;
+        for (ModuleNode* import : mainModule->imports) {
+            imports.emplace_back(import->declarations);
+        }
+
+        llvm::Module* mm = compileModule(mainModule->AST, mainModule->name, imports, mainModule->arena, options);
+        mainModule->AST.clear();
+        mainModule->arena.reset();
+
+        return mm;
+    }
+
+    void linkImportGraph(llvm::Module* mainModule, const std::vector<ModuleNode*>& modules) {
+        for (ModuleNode* node : modules) {
+            if (node->bitcode.empty()) continue;
+
+            auto im = llvm::parseBitcodeFile(llvm::MemoryBufferRef(node->bitcode, node->name), mainModule->getContext());
+            if (!im) {
+                throw std::runtime_error("Could not read module " + node->name + ": " + llvm::toString(im.takeError()));
+            }
+            if (llvm::Linker::linkModules(*mainModule, std::move(im.get()))) {
+                throw std::runtime_error("Could not link module " + node->name);
+            }
+            node->bitcode.clear();
+        }
+
+        // nothing outside of the program can call anything but main now
+        llvm::internalizeModule(*mainModule, [](const llvm::GlobalValue& GV) {
+            return GV.getName() == "main";
+        });
+    }
+
+}
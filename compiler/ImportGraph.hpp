@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+
+#include "../parser/Parser.hpp"
+#include "../parser/Statements.hpp"
+
+#include "llvm/IR/Module.h"
+
+#include <filesystem>
+namespace fs = std::filesystem;
+
+namespace compiler {
+
+    // A source file of the program and the modules it imports
+    struct ModuleNode {
+        fs::path path;
+        std::string name; // file name, the object file is called <name>.o
+        std::string_view code; // owned by the source manager
+        std::string cacheKey; // empty when the cache is disabled
+
+        std::vector<parser::Statement*> AST; // empty until parsed, cached modules are never parsed
+        parser::Arena arena;                 // owns the AST, freed as soon as the module is compiled
+        std::vector<ModuleNode*> imports;
+
+        std::string declarations; // exported declarations as bitcode, set once compiled
+        std::string bitcode;      // whole compiled module, only kept when objects are not emitted
+    };
+
+    struct ImportGraph {
+        std::map<std::string, ModuleNode*> nodes; // by canonical path
+        std::vector<std::string> stack;           // modules currently being visited
+        std::vector<ModuleNode*> order;           // imports always before their importers
+    };
+
+    std::vector<ModuleNode*> buildImportGraph(const fs::path& mainFile, const parser::CompileOptions& options);
+    ModuleNode* addModuleNode(ImportGraph& graph, const fs::path& path, const std::string& name, const parser::CompileOptions& options);
+    void parseModuleNode(ModuleNode* node, const parser::CompileOptions& options);
+
+    void compileImportedModule(ModuleNode* node, const parser::CompileOptions& options);
+    void compileImportsInParallel(const std::vector<ModuleNode*>& modules, const parser::CompileOptions& options);
+    llvm::Module* compileImportGraph(const std::vector<ModuleNode*>& modules, const parser::CompileOptions& options);
+    void linkImportGraph(llvm::Module* mainModule, const std::vector<ModuleNode*>& modules);
+
+}
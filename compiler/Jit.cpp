@@ -0,0 +1,92 @@
+#include "Jit.hpp"
+#include "Compiler.hpp"
+
+#include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
+#include "llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h"
+#include "llvm/ExecutionEngine/Orc/TargetProcess/TargetExecutionUtils.h"
+
+namespace compiler {
+
+    int runModule(llvm::Module* mainModule, const std::vector<ModuleNode*>& modules, const std::vector<std::string>& args, const parser::CompileOptions& options) {
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmPrinter();
+
+        auto JTMB = llvm::orc::JITTargetMachineBuilder::detectHost();
+        if (!JTMB) {
+            llvm::errs() << llvm::toString(JTMB.takeError()) << '\n';
+            return 1;
+        }
+
+        // explicit -mcpu/-mattr, the jit uses the host cpu otherwise
+        if (options.cpu != "generic" || !options.features.empty()) {
+            std::string cpu, features;
+            parser::Parser::getTargetCPU(options, cpu, features);
+            JTMB->setCPU(cpu);
+            JTMB->addFeatures(std::vector<std::string> { features });
+        }
+
+        llvm::CodeGenOpt::Level OL = llvm::CodeGenOpt::None;
+        if (options.optLevel == 1 || options.sizeLevel > 0) OL = llvm::CodeGenOpt::Less;
+        if (options.optLevel == 2 && options.sizeLevel == 0) OL = llvm::CodeGenOpt::Default;
+        if (options.optLevel >= 3 && options.sizeLevel == 0) OL = llvm::CodeGenOpt::Aggressive;
+        JTMB->setCodeGenOptLevel(OL);
+
+        auto TM = JTMB->createTargetMachine();
+        if (!TM) {
+            llvm::errs() << llvm::toString(TM.takeError()) << '\n';
+            return 1;
+        }
+
+        auto J = llvm::orc::LLJITBuilder().setJITTargetMachineBuilder(*JTMB).create();
+        if (!J) {
+            llvm::errs() << llvm::toString(J.takeError()) << '\n';
+            return 1;
+        }
+
+        // printf, scanf and the rest of libc come from this process
+        auto generator = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess((*J)->getDataLayout().getGlobalPrefix());
+        if (!generator) {
+            llvm::errs() << llvm::toString(generator.takeError()) << '\n';
+            return 1;
+        }
+        (*J)->getMainJITDylib().addGenerator(std::move(*generator));
+
+        for (ModuleNode* node : modules) {
+            if (node->bitcode.empty()) continue;
+            if (llvm::Error err = addJitModule(**J, TM->get(), node->bitcode, options)) {
+                llvm::errs() << llvm::toString(std::move(err)) << '\n';
+                return 1;
+            }
+        }
+        if (llvm::Error err = addJitModule(**J, TM->get(), writeBitcode(mainModule), options)) {
+            llvm::errs() << llvm::toString(std::move(err)) << '\n';
+            return 1;
+        }
+
+        auto mainSymbol = (*J)->lookup("main");
+        if (!mainSymbol) {
+            llvm::errs() << llvm::toString(mainSymbol.takeError()) << '\n';
+            return 1;
+        }
+
+        auto mainFunction = (int (*)(int, char*[])) mainSymbol->getAddress();
+        std::string programName = mainModule->getName().str();
+        return llvm::orc::runAsMain(mainFunction, args, llvm::StringRef(programName));
+    }
+
+    llvm::Error addJitModule(llvm::orc::LLJIT& jit, llvm::TargetMachine* targetMachine, const std::string& bitcode, const parser::CompileOptions& options) {
+        // every module gets its own context, the jit may compile them on different threads
+        auto context = std::make_unique<llvm::LLVMContext>();
+
+        auto mod = llvm::parseBitcodeFile(llvm::MemoryBufferRef(bitcode, "module"), *context);
+        if (!mod) return mod.takeError();
+
+        (*mod)->setDataLayout(jit.getDataLayout());
+        (*mod)->setTargetTriple(jit.getTargetTriple().str());
+        parser::Parser::setTargetAttributes(mod->get(), std::string(targetMachine->getTargetCPU()), std::string(targetMachine->getTargetFeatureString()));
+        parser::Parser::optimizeModule(mod->get(), targetMachine, options);
+
+        return jit.addIRModule(llvm::orc::ThreadSafeModule(std::move(*mod), std::move(context)));
+    }
+
+}
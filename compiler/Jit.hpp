@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "ImportGraph.hpp"
+#include "../parser/Parser.hpp"
+
+#include "llvm/IR/Module.h"
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "llvm/ExecutionEngine/Orc/ThreadSafeModule.h"
+
+namespace compiler {
+
+    int runModule(llvm::Module* mainModule, const std::vector<ModuleNode*>& modules, const std::vector<std::string>& args, const parser::CompileOptions& options);
+    llvm::Error addJitModule(llvm::orc::LLJIT& jit, llvm::TargetMachine* targetMachine, const std::string& bitcode, const parser::CompileOptions& options);
+
+}
@@ -0,0 +1,114 @@
+#include "Resolver.hpp"
+
+#include <stdexcept>
+#include <string>
+
+#include "llvm/ADT/DenseMap.h"
+
+namespace compiler {
+
+    namespace {
+
+        class Resolver {
+            public:
+                FunctionSlots slots;
+
+                int define(int symbol, std::string_view name) {
+                    int slot = slots.names.size();
+                    slots.names.push_back(name);
+                    slots.addressTaken.push_back(false);
+
+                    auto it = bindings.find(symbol);
+                    shadowed.emplace_back(symbol, it == bindings.end() ? -1 : it->second);
+                    bindings[symbol] = slot;
+                    return slot;
+                }
+
+                void bind(parser::Statement* statement) {
+                    auto it = bindings.find(statement->symbol);
+                    if (it == bindings.end()) {
+                        throw std::runtime_error("Unknown variable " + std::string(statement->value));
+                    }
+                    statement->slot = it->second;
+                }
+
+                // definitions made inside a block are unbound again when it ends
+                size_t enter() { return shadowed.size(); }
+                void leave(size_t mark) {
+                    while (shadowed.size() > mark) {
+                        auto& s = shadowed.back();
+                        if (s.second < 0) {
+                            bindings.erase(s.first);
+                        } else {
+                            bindings[s.first] = s.second;
+                        }
+                        shadowed.pop_back();
+                    }
+                }
+
+                // visits statements in the order the compiler emits them
+                void resolve(parser::Statement* statement) {
+                    switch (statement->type) {
+                        case parser::StatementType::VARIABLE_DEFINITON:
+                            // the initial value still sees an outer variable of the same name
+                            for (parser::Statement* s : statement->statements) resolve(s);
+                            statement->slot = define(statement->symbol, statement->value);
+                            return;
+                        case parser::StatementType::VARIABLE_CALL:
+                            bind(statement);
+                            return;
+                        case parser::StatementType::GET_ALLOCA:
+                            bind(statement);
+                            slots.addressTaken[statement->slot] = true;
+                            return;
+                        case parser::StatementType::VARIABLE_ASSIGNMENT:
+                            resolve(statement->statements[0]);
+                            bind(statement);
+                            return;
+                        case parser::StatementType::IF:
+                        case parser::StatementType::IFELSE: {
+                            resolve(statement->statements[0]);
+                            for (size_t i = 1; i < statement->statements.size(); i++) {
+                                size_t mark = enter();
+                                resolve(statement->statements[i]);
+                                leave(mark);
+                            }
+                            return;
+                        }
+                        case parser::StatementType::FOR_LOOP: {
+                            // the end condition is the guard in front of the body, so it does not see definitions of the body
+                            size_t mark = enter();
+                            resolve(statement->statements[0]);
+                            resolve(statement->statements[1]);
+                            size_t bodyMark = enter();
+                            resolve(statement->statements[3]);
+                            leave(bodyMark);
+                            resolve(statement->statements[2]);
+                            leave(mark);
+                            return;
+                        }
+                        default:
+                            for (parser::Statement* s : statement->statements) resolve(s);
+                            return;
+                    }
+                }
+
+            private:
+                llvm::DenseMap<int, int> bindings;         // symbol -> slot of the innermost visible definition
+                std::vector<std::pair<int, int>> shadowed; // symbol and its previous slot (-1 if unbound), per definition
+        };
+
+    }
+
+    FunctionSlots resolveFunction(parser::FunctionDefinition* function) {
+        Resolver resolver;
+        for (auto& arg : function->args) {
+            resolver.define(arg.symbol, arg.name);
+        }
+        for (parser::Statement* s : function->statements) {
+            resolver.resolve(s);
+        }
+        return std::move(resolver.slots);
+    }
+
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+#include "../parser/Statements.hpp"
+
+namespace compiler {
+
+    // Variables of one function, indexed by slot
+    struct FunctionSlots {
+        std::vector<std::string_view> names;
+        std::vector<bool> addressTaken; // these have to live in memory
+    };
+
+    // binds every variable definition and reference of a function to a slot, arguments take the first slots
+    FunctionSlots resolveFunction(parser::FunctionDefinition* function);
+
+}
@@ -0,0 +1,36 @@
+#include "SourceManager.hpp"
+
+#include "llvm/Support/MemoryBuffer.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+namespace compiler {
+
+    // every file is loaded once, tokens and diagnostics point into these buffers
+    std::map<std::string, std::unique_ptr<llvm::MemoryBuffer>> sources;
+    std::mutex sourcesMutex;
+
+    std::string_view loadSource(const fs::path& path) {
+        std::string id = fs::weakly_canonical(path).string();
+
+        std::lock_guard<std::mutex> lock(sourcesMutex);
+        auto it = sources.find(id);
+        if (it != sources.end()) {
+            return std::string_view(it->second->getBufferStart(), it->second->getBufferSize());
+        }
+
+        // large files are memory mapped, small ones are read with a single read
+        llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer = llvm::MemoryBuffer::getFile(path.string());
+        if (!buffer) {
+            throw std::runtime_error("Can't read " + path.string() + ": " + buffer.getError().message());
+        }
+
+        llvm::MemoryBuffer* b = buffer->get();
+        sources[id] = std::move(*buffer);
+        return std::string_view(b->getBufferStart(), b->getBufferSize());
+    }
+
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include <filesystem>
+namespace fs = std::filesystem;
+
+namespace compiler {
+
+    // contents of a source file, the view stays valid until the program exits
+    std::string_view loadSource(const fs::path& path);
+
+}
@@ -2,6 +2,8 @@
 #include "parser/Parser.hpp"
 #include "parser/Statements.hpp"
 #include "compiler/Compiler.hpp"
+#include "compiler/ImportGraph.hpp"
+#include "compiler/Jit.hpp"
 
 
 #include <string>
@@ -16,32 +18,104 @@ int main(int argc, char **argv) {
 
     // create arg object
     std::vector<std::string> args(argv, argv + argc);
-    
-    // open file
-    std::ifstream file;
-    file.open(args[1]);
 
-    std::string line, allCode="";
-    while (std::getline(file, line)) {
-        allCode += line + '\n';
+    // "c-cash run <main file> [args]" runs the program with the jit instead of emitting objects
+    int firstArg = 1;
+    bool run = false;
+    if (args.size() > 1 && args[1] == "run") {
+        run = true;
+        firstArg = 2;
     }
 
-    std::vector<tokenizer::Token> tokens = tokenizer::tokenize(allCode);
+    // parse options
+    parser::CompileOptions options;
+    options.verbose = !run;
+    std::string mainFile = "";
+    std::vector<std::string> programArgs;
+    for (size_t i = firstArg; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        if (!mainFile.empty() && run) {
+            programArgs.emplace_back(arg);
+        } else if (arg == "-O0" || arg == "-O1" || arg == "-O2" || arg == "-O3") {
+            options.optLevel = arg[2] - '0';
+            options.sizeLevel = 0;
+        } else if (arg == "-Os" || arg == "-Oz") {
+            options.optLevel = 2;
+            options.sizeLevel = (arg == "-Os" ? 1 : 2);
+        } else if (arg.rfind("-mcpu=", 0) == 0) {
+            options.cpu = arg.substr(6);
+        } else if (arg.rfind("-mattr=", 0) == 0) {
+            options.features = arg.substr(7);
+        } else if (arg == "-fno-ssa-locals") {
+            options.ssaLocals = false;
+        } else if (arg == "-fssa-locals") {
+            options.ssaLocals = true;
+        } else if (arg == "-fno-eval-calls") {
+            options.evalCalls = false;
+        } else if (arg == "-feval-calls") {
+            options.evalCalls = true;
+        } else if (arg == "-fbounds-checks") {
+            options.boundsChecks = true;
+        } else if (arg == "-fno-bounds-checks") {
+            options.boundsChecks = false;
+        } else if (arg.rfind("--cache-dir=", 0) == 0) {
+            options.cacheDir = arg.substr(12);
+        } else if (arg == "-fno-parallel-imports") {
+            options.parallelImports = false;
+        } else if (arg == "-flto=thin") {
+            options.thinLTO = true;
+        } else if (arg == "--whole-program") {
+            options.wholeProgram = true;
+        } else if (arg == "-q") {
+            options.verbose = false;
+        } else if (arg == "-v") {
+            options.verbose = true;
+        } else if (arg == "-march=native") {
+            options.cpu = "native";
+        } else if (arg[0] == '-') {
+            std::cerr << "Unknown option: " << arg << '\n';
+            return 1;
+        } else {
+            mainFile = arg;
+        }
+    }
 
-    for (auto t : tokens) {
-        t.debug_print();
+    if (options.cpu == "help" || options.features == "help") {
+        parser::Parser::printTargetHelp();
+        return 0;
     }
 
-    std::vector<parser::Statement*> AST = parser::Parser::parse(tokens);
+    if (mainFile.empty()) {
+        std::cerr << "Usage: c-cash [-O0|-O1|-O2|-O3|-Os|-Oz] [-mcpu=<cpu>|native|help] [-mattr=<features>|help] [-f[no-]ssa-locals] [--cache-dir=<dir>] [-fno-parallel-imports] [--whole-program] [-flto=thin] [-f[no-]eval-calls] [-f[no-]bounds-checks] <main file>\n";
+        std::cerr << "       c-cash run [options] <main file> [args]\n";
+        return 1;
+    }
 
-    for (auto s : AST) {
-        s->debug_print(0);
+    std::string targetError = parser::Parser::checkTarget(options);
+    if (!targetError.empty()) {
+        std::cerr << targetError << '\n';
+        return 1;
     }
 
-    fs::path p (args[1]);
+    // the cache only holds object files
+    if (run || options.wholeProgram) {
+        options.emitObjects = false;
+        options.cacheDir = "";
+    }
+    
+    // load main file and everything it imports
+    std::vector<compiler::ModuleNode*> modules = compiler::buildImportGraph(fs::path(mainFile), options);
 
-    llvm::Module* mm = compiler::compileModule(AST, compiler::base_name(args[1]), p);
+    llvm::Module* mm = compiler::compileImportGraph(modules, options);
+
+    if (options.wholeProgram) {
+        compiler::linkImportGraph(mm, modules);
+    }
+
+    if (run) {
+        return compiler::runModule(mm, modules, programArgs, options);
+    }
 
-    parser::Parser::saveCompilation(mm, compiler::base_name(args[1]) + ".o");
+    parser::Parser::saveCompilation(mm, compiler::base_name(mainFile) + ".o", options);
 
 }
\ No newline at end of file
@@ -2,30 +2,173 @@
 
 namespace parser {
 
-    int cTokenI = 0;
-    tokenizer::Token* cToken = nullptr;
-    std::vector<tokenizer::Token> Tokens;
-    std::map<char, int> operator_precedence = { {'<', 20}, {'>', 20}, {'+', 20}, {'-', 20}, {'*', 40}, {'/', 40} };
+    const std::map<int, int> operator_precedence = {
+        {'<', 10}, {'>', 10}, {tokenizer::TokenKind::LESS_EQUAL, 10}, {tokenizer::TokenKind::GREATER_EQUAL, 10},
+        {tokenizer::TokenKind::EQUAL_EQUAL, 10}, {tokenizer::TokenKind::NOT_EQUAL, 10},
+        {'+', 20}, {'-', 20}, {'*', 40}, {'/', 40}
+    };
 
-    tokenizer::Token* Parser::get_next() {
-        if (cTokenI >= Tokens.size()) return nullptr;
-        cToken = &Tokens[cTokenI++];
-        return cToken;
+    Parser::Parser(std::string_view source, Arena& arena) : lexer(source), arena(arena) {}
+
+    // the current token stays in place at the end of the source
+    bool Parser::get_next() {
+        tokenizer::Token token;
+        if (!lexer.next(token)) {
+            ended = true;
+            return false;
+        }
+        cToken = token;
+        return true;
     }
     bool Parser::is_next() {
-        return cTokenI < Tokens.size()-1;
+        return !ended;
+    }
+
+    void Parser::initializeTargets() {
+        // target registration is not thread safe
+        static std::once_flag targetsInitialized;
+        std::call_once(targetsInitialized, []() {
+            llvm::InitializeAllTargetInfos();
+            llvm::InitializeAllTargets();
+            llvm::InitializeAllTargetMCs();
+            llvm::InitializeAllAsmParsers();
+            llvm::InitializeAllAsmPrinters();
+        });
+    }
+
+    void Parser::getTargetCPU(const CompileOptions& options, std::string& cpu, std::string& features) {
+        cpu = options.cpu;
+        features = "";
+
+        if (cpu == "native") {
+            cpu = std::string(llvm::sys::getHostCPUName());
+
+            llvm::StringMap<bool> hostFeatures;
+            if (llvm::sys::getHostCPUFeatures(hostFeatures)) {
+                for (auto& f : hostFeatures) {
+                    if (!features.empty()) features += ',';
+                    features += (f.second ? '+' : '-') + f.first().str();
+                }
+            }
+        }
+
+        // explicit -mattr features go last so they override host ones
+        if (!options.features.empty()) {
+            if (!features.empty()) features += ',';
+            features += options.features;
+        }
+    }
+
+    std::string Parser::checkTarget(const CompileOptions& options) {
+        initializeTargets();
+
+        std::string TargetTriple = llvm::sys::getDefaultTargetTriple();
+        std::string Error;
+        auto Target = llvm::TargetRegistry::lookupTarget(TargetTriple, Error);
+        if (!Target) return Error;
+
+        std::unique_ptr<llvm::MCSubtargetInfo> STI(Target->createMCSubtargetInfo(TargetTriple, "", ""));
+
+        if (options.cpu != "native" && !STI->isCPUStringValid(options.cpu)) {
+            return "Unknown cpu '" + options.cpu + "' for " + TargetTriple + ", see -mcpu=help";
+        }
+
+        // features are a comma separated list of +name or -name
+        llvm::SmallVector<llvm::StringRef, 8> features;
+        llvm::StringRef(options.features).split(features, ',', -1, false);
+        for (llvm::StringRef feature : features) {
+            // toggling always changes the bits of a known feature, llvm only warns about unknown ones
+            llvm::FeatureBitset before = STI->getFeatureBits();
+            bool known = (feature.startswith("+") || feature.startswith("-")) && STI->ToggleFeature(feature) != before;
+            STI->setFeatureBits(before);
+            if (!known) {
+                return "Unknown target feature '" + feature.str() + "' for " + TargetTriple + ", see -mattr=help";
+            }
+        }
+
+        return "";
+    }
+
+    void Parser::printTargetHelp() {
+        initializeTargets();
+
+        std::string TargetTriple = llvm::sys::getDefaultTargetTriple();
+        std::string Error;
+        auto Target = llvm::TargetRegistry::lookupTarget(TargetTriple, Error);
+        if (!Target) {
+            llvm::errs() << Error << '\n';
+            return;
+        }
+
+        // the subtarget prints both tables for the cpu "help"
+        std::unique_ptr<llvm::MCSubtargetInfo> STI(Target->createMCSubtargetInfo(TargetTriple, "help", ""));
+    }
+
+    void Parser::setTargetAttributes(llvm::Module* mod, const std::string& cpu, const std::string& features) {
+        // let optimization passes tune for the selected cpu
+        for (llvm::Function& F : mod->getFunctionList()) {
+            if (F.isDeclaration()) continue;
+            F.addFnAttr("target-cpu", cpu);
+            if (!features.empty()) F.addFnAttr("target-features", features);
+        }
+    }
+
+    void Parser::optimizeModule(llvm::Module* mod, llvm::TargetMachine* targetMachine, const CompileOptions& options, llvm::raw_ostream* thinLTOBitcode) {
+        #if LLVM_VERSION_MAJOR >= 14
+        using OptimizationLevel = llvm::OptimizationLevel;
+        #else
+        using OptimizationLevel = llvm::PassBuilder::OptimizationLevel;
+        #endif
+
+        OptimizationLevel level = OptimizationLevel::O0;
+        if (options.sizeLevel == 1) level = OptimizationLevel::Os;
+        else if (options.sizeLevel >= 2) level = OptimizationLevel::Oz;
+        else if (options.optLevel == 1) level = OptimizationLevel::O1;
+        else if (options.optLevel == 2) level = OptimizationLevel::O2;
+        else if (options.optLevel >= 3) level = OptimizationLevel::O3;
+
+        // same defaults as clang uses for these levels
+        llvm::PipelineTuningOptions PTO;
+        PTO.LoopUnrolling = options.optLevel > 1;
+        PTO.LoopVectorization = options.optLevel > 1 && options.sizeLevel < 2;
+        PTO.SLPVectorization = options.optLevel > 1 && options.sizeLevel < 2;
+
+        llvm::LoopAnalysisManager LAM;
+        llvm::FunctionAnalysisManager FAM;
+        llvm::CGSCCAnalysisManager CGAM;
+        llvm::ModuleAnalysisManager MAM;
+
+        llvm::PassBuilder PB(targetMachine, PTO);
+
+        PB.registerModuleAnalyses(MAM);
+        PB.registerCGSCCAnalyses(CGAM);
+        PB.registerFunctionAnalyses(FAM);
+        PB.registerLoopAnalyses(LAM);
+        PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+
+        // ThinLTO only runs the pre-link part here, the rest is done by the linker
+        llvm::ModulePassManager MPM;
+        if (level == OptimizationLevel::O0) {
+            MPM = PB.buildO0DefaultPipeline(level, thinLTOBitcode != nullptr);
+        } else if (thinLTOBitcode) {
+            MPM = PB.buildThinLTOPreLinkDefaultPipeline(level);
+        } else {
+            MPM = PB.buildPerModuleDefaultPipeline(level);
+        }
+
+        if (thinLTOBitcode) {
+            MPM.addPass(llvm::ThinLTOBitcodeWriterPass(*thinLTOBitcode, nullptr));
+        }
+
+        MPM.run(*mod, MAM);
     }
 
-    void Parser::saveCompilation(llvm::Module* mod, const std::string& filename) {
+    void Parser::saveCompilation(llvm::Module* mod, const std::string& filename, const CompileOptions& options) {
         // #ifdef __linux__ 
 
         auto TargetTriple = llvm::sys::getDefaultTargetTriple();
 
-        llvm::InitializeAllTargetInfos();
-        llvm::InitializeAllTargets();
-        llvm::InitializeAllTargetMCs();
-        llvm::InitializeAllAsmParsers();
-        llvm::InitializeAllAsmPrinters();
+        initializeTargets();
 
         std::string Error;
         auto Target = llvm::TargetRegistry::lookupTarget(TargetTriple, Error);
@@ -35,16 +178,23 @@ namespace parser {
             return;
         }
 
-        auto CPU = "generic";
-        auto Features = "";
+        std::string CPU, Features;
+        getTargetCPU(options, CPU, Features);
+
+        llvm::CodeGenOpt::Level OL = llvm::CodeGenOpt::None;
+        if (options.optLevel == 1 || options.sizeLevel > 0) OL = llvm::CodeGenOpt::Less;
+        if (options.optLevel == 2 && options.sizeLevel == 0) OL = llvm::CodeGenOpt::Default;
+        if (options.optLevel >= 3 && options.sizeLevel == 0) OL = llvm::CodeGenOpt::Aggressive;
 
         llvm::TargetOptions opt;
         auto RM = llvm::Optional<llvm::Reloc::Model>();
-        auto TargetMachine = Target->createTargetMachine(TargetTriple, CPU, Features, opt, RM);
+        auto TargetMachine = Target->createTargetMachine(TargetTriple, CPU, Features, opt, RM, llvm::None, OL);
 
         mod->setDataLayout(TargetMachine->createDataLayout());
         mod->setTargetTriple(TargetTriple);
 
+        setTargetAttributes(mod, CPU, Features);
+
         std::error_code EC;
         llvm::raw_fd_ostream dest(filename, EC, llvm::sys::fs::OF_None);
 
@@ -53,24 +203,15 @@ namespace parser {
             return;
         }
 
-        
-        // Pass manager
-        // llvm::LoopAnalysisManager LAM;
-        // llvm::FunctionAnalysisManager FAM;
-        // llvm::CGSCCAnalysisManager CGAM;
-        // llvm::ModuleAnalysisManager MAM;
-
-        // llvm::PassBuilder PB;
-
-        // PB.registerModuleAnalyses(MAM);
-        // PB.registerCGSCCAnalyses(CGAM);
-        // PB.registerFunctionAnalyses(FAM);
-        // PB.registerLoopAnalyses(LAM);
-        // PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
-
-        // llvm::ModulePassManager MPM = PB.buildPerModuleDefaultPipeline(llvm::PassBuilder::OptimizationLevel::O2);
+        // bitcode with module summary for a ThinLTO capable linker
+        if (options.thinLTO) {
+            optimizeModule(mod, TargetMachine, options, &dest);
+            dest.flush();
+            return;
+        }
 
-        // MPM.run(*mod, MAM);
+        // Pass manager
+        optimizeModule(mod, TargetMachine, options);
 
         llvm::legacy::PassManager pass;
         auto FileType = llvm::CGFT_ObjectFile;
@@ -89,18 +230,10 @@ namespace parser {
 
     }
 
-    std::vector<Statement*> Parser::parse(std::vector<tokenizer::Token> tokens) {
-        int cTokenITMP = cTokenI;
-        tokenizer::Token* cTokenTMP = cToken;
-        auto tokensTMP = Tokens;
-
-        cTokenI = 0;
-        Tokens = tokens;
+    std::vector<Statement*> Parser::parse() {
         std::vector<Statement*> result;
 
-        std::cout << "Compilation debug:\n";
-
-        get_next();
+        if (!get_next()) return result;
         while(is_next()) {
 
             // parse function declaration
@@ -114,453 +247,463 @@ namespace parser {
             }
         }
 
-        std::cout << result.size() << '\n';
-
-        cTokenI = cTokenITMP;
-        cToken = cTokenTMP;
-        Tokens = tokensTMP;
-
         return result;
     }
 
-    std::optional<tokenizer::Token*> Parser::expect_identifier(const std::string& name = std::string()) {
-        if (cToken->type != tokenizer::TokenType::IDENTIFIER) { return std::nullopt; }
-        if (!name.empty() && cToken->value != name) { return std::nullopt; }
+    std::optional<tokenizer::Token> Parser::expect_identifier() {
+        if (cToken.kind != tokenizer::TokenKind::NAME) { return std::nullopt; }
 
-        std::regex pattern("[A-Za-z_]\\w*");
-        std::smatch result;
-        if(!regex_match(cToken->value, result, pattern)) { return std::nullopt; }
-
-        tokenizer::Token* returnToken = cToken;
+        tokenizer::Token returnToken = cToken;
         get_next();
         return returnToken;
     }
 
-    std::optional<tokenizer::Token*> Parser::expect_double() {
-        if(cToken->type != tokenizer::TokenType::DOUBLE ) { return std::nullopt; }
+    std::optional<tokenizer::Token> Parser::expect_keyword(int kind) {
+        if (cToken.kind != kind) { return std::nullopt; }
 
-        tokenizer::Token* returnToken = cToken;
+        tokenizer::Token returnToken = cToken;
         get_next();
         return returnToken;
     }
 
-    std::optional<tokenizer::Token*> Parser::expect_integer() {
-        if(cToken->type != tokenizer::TokenType::INTEGER ) { return std::nullopt; }
+    std::optional<tokenizer::Token> Parser::expect_double() {
+        if(cToken.type != tokenizer::TokenType::DOUBLE ) { return std::nullopt; }
 
-        tokenizer::Token* returnToken = cToken;
+        tokenizer::Token returnToken = cToken;
         get_next();
         return returnToken;
     }
-    std::optional<tokenizer::Token*> Parser::expect_long_int() {
-        if(cToken->type != tokenizer::TokenType::INTEGER ) { return std::nullopt; }
-        tokenizer::Token* returnToken = cToken;
-        get_next();
-        if(cToken->type != tokenizer::TokenType::IDENTIFIER || cToken->value != "l") { cTokenI-=2; get_next(); return std::nullopt; }
 
+    std::optional<tokenizer::Token> Parser::expect_integer() {
+        if(cToken.type != tokenizer::TokenType::INTEGER ) { return std::nullopt; }
+
+        tokenizer::Token returnToken = cToken;
         get_next();
         return returnToken;
     }
 
     std::optional<Statement*> Parser::expect_array() {
-        if (!expect_operator("[").has_value()) { return std::nullopt; }
-        Statement* stmt = new Statement(StatementType::ARRAY_DEFINITION, "");
+        if (!expect_operator('[').has_value()) { return std::nullopt; }
+        Statement* stmt = arena.statement(StatementType::ARRAY_DEFINITION, "");
+        llvm::SmallVector<Statement*, 8> elements;
 
         bool isFirst = true;
-        while (!expect_operator("]").has_value()) {
+        while (!expect_operator(']').has_value()) {
             if (!isFirst) {
-                if (!expect_operator(",").has_value()) { error(cToken, "Expected ',' to separate array arguments"); }
+                if (!expect_operator(',').has_value()) { error(cToken, "Expected ',' to separate array arguments"); }
             }
             isFirst = false;
 
-            std::optional<Statement*> v = expect_value_expression(false, false);
+            std::optional<Statement*> v = expect_value_expression();
             if (!v.has_value()) { error(cToken, "Expected value in array definition"); }
-            stmt->statements.emplace_back(v.value());
+            elements.emplace_back(v.value());
         }
 
+        stmt->statements = arena.array<Statement*>(elements);
         return stmt;
     }
 
     std::optional<Statement*> Parser::expect_string() {
-        if (!expect_operator("\"").has_value()) { return std::nullopt; }
-        Statement* stmt = new Statement(StatementType::STRING, "");
-        while (!expect_operator("\"").has_value()) {
-            stmt->value += cToken->value + " ";
-            get_next();
+        if (!expect_operator('"').has_value()) { return std::nullopt; }
+        std::string value;
+        while (!expect_operator('"').has_value()) {
+            value += tokenizer::unescape(cToken.value);
+            value += ' ';
+            if (!get_next()) { error(cToken, "Unterminated string literal"); }
         }
-        if (stmt->value[stmt->value.size() - 1] == ' ') {
-            stmt->value = stmt->value.substr(0, stmt->value.size()-1);
+        if (!value.empty() && value[value.size() - 1] == ' ') {
+            value.pop_back();
         }
-        return stmt;
+        return arena.statement(StatementType::STRING, tokenizer::internString(value));
     }
 
-    std::optional<tokenizer::Token*> Parser::expect_char() {
-        if(cToken->type != tokenizer::TokenType::OPERATOR ) { return std::nullopt; }
-        get_next();
+    std::optional<tokenizer::Token> Parser::expect_char() {
+        if (!expect_operator('\'').has_value()) { return std::nullopt; }
 
-        if(cToken->value.size() != 1) { cTokenI-=2; get_next(); return std::nullopt; }
-        tokenizer::Token* returnToken = cToken;
+        if(cToken.value.size() != 1) { error(cToken, "Expected a single character"); }
+        tokenizer::Token returnToken = cToken;
         get_next();
 
-        if(cToken->type != tokenizer::TokenType::OPERATOR ) { cTokenI-=3; get_next(); return std::nullopt; }
-
-        get_next();
+        if (!expect_operator('\'').has_value()) { error(cToken, "Expected '\''"); }
         return returnToken;
     }
-    std::optional<tokenizer::Token*> Parser::expect_boolean() {
-        if(cToken->type != tokenizer::TokenType::IDENTIFIER ) { return std::nullopt; }
+    std::optional<tokenizer::Token> Parser::expect_boolean() {
+        if(cToken.type != tokenizer::TokenType::IDENTIFIER ) { return std::nullopt; }
 
-        if (cToken->value != "true" && cToken->value != "false") { return std::nullopt; }
-        tokenizer::Token* returnToken = cToken;
+        if (cToken.value != "true" && cToken.value != "false") { return std::nullopt; }
+        tokenizer::Token returnToken = cToken;
         get_next();
-        // returnToken->value = (cToken->value != "true" ? "1" : "0");
+        // returnToken->value = (cToken.value != "true" ? "1" : "0");
         return returnToken;
     }
 
-    std::optional<tokenizer::Token*> Parser::expect_operator(const std::string &name) {
-        if(cToken->type != tokenizer::TokenType::OPERATOR ) { return std::nullopt; }
-        if(!name.empty() && cToken->value != name) { return std::nullopt; }
+    std::optional<tokenizer::Token> Parser::expect_operator(int kind) {
+        if(cToken.type != tokenizer::TokenType::OPERATOR ) { return std::nullopt; }
+        if(kind != tokenizer::TokenKind::NO_KIND && cToken.kind != kind) { return std::nullopt; }
 
-        tokenizer::Token* returnToken = cToken;
+        tokenizer::Token returnToken = cToken;
         get_next();
         return returnToken;
     }
 
-    std::optional<tokenizer::Token*> Parser::expect_type(const std::string& name = std::string()) {
-        if(cToken->type != tokenizer::TokenType::IDENTIFIER ) { return std::nullopt; }
-        if (std::find(std::begin(data_types), std::end(data_types), cToken->value) == std::end(data_types)) { return std::nullopt; }
-        if(!name.empty() && cToken->value != name) { return std::nullopt; }
+    std::optional<std::string_view> Parser::expect_type(const std::string& name) {
+        if(cToken.type != tokenizer::TokenType::IDENTIFIER ) { return std::nullopt; }
+        if (std::find(std::begin(data_types), std::end(data_types), cToken.value) == std::end(data_types)) { return std::nullopt; }
+        if(!name.empty() && cToken.value != name) { return std::nullopt; }
 
-        tokenizer::Token* returnToken = cToken;
+        std::string_view base = cToken.value;
         get_next();
 
-        if(expect_operator("*").has_value()) { // pointer type
-            returnToken->value = returnToken->value + '*';
+        // plain types stay views into the source
+        if (cToken.kind != '*' && cToken.kind != '[' && base != "vec") { return base; }
+
+        std::string type(base);
+        if (base == "vec") { // vector type, vec<element type,lanes>
+            if (!expect_operator('<').has_value()) { error(cToken, "Expected '<' after vec"); }
+            std::optional<std::string_view> element = expect_type();
+            if (!element.has_value() || element.value() == "void" || element.value().rfind("vec", 0) == 0) { error(cToken, "Expected scalar vector element type"); }
+            if (!expect_operator(',').has_value()) { error(cToken, "Expected ','"); }
+            std::optional<tokenizer::Token> lanes = expect_integer();
+            if (!lanes.has_value()) { error(cToken, "Expected number of vector lanes"); }
+            unsigned long long laneCount = std::strtoull(std::string(lanes.value().value).c_str(), nullptr, 10);
+            if (laneCount == 0 || laneCount > maxVectorLanes) { error(lanes.value(), "Vector lanes have to be between 1 and " + std::to_string(maxVectorLanes)); }
+            if (!expect_operator('>').has_value()) { error(cToken, "Expected '>'"); }
+            type += '<' + std::string(element.value()) + ',' + std::string(lanes.value().value) + '>';
         }
 
-        if(expect_operator("[").has_value()) { // array type
-            std::optional<tokenizer::Token*> num = expect_integer();
-            if (!expect_operator("]").has_value()) { error(cToken, "Expected ']'"); }
-            returnToken->value = returnToken->value + '[' + num.value()->value + ']';
+        if(expect_operator('*').has_value()) { // pointer type
+            type += '*';
         }
 
-        return returnToken;
-    }
+        if(expect_operator('[').has_value()) { // array type
+            std::optional<tokenizer::Token> num = expect_integer();
+            if (!expect_operator(']').has_value()) { error(cToken, "Expected ']'"); }
+            type += '[' + std::string(num.value().value) + ']';
+        }
 
-    std::optional<Statement*> Parser::expect_array_call() {
-        int tBegin = cTokenI;
-        // TODO: allow nested array call and other statements than variable call
-        std::optional<Statement*> nameToken = expect_variable_call();
-        if (!nameToken.has_value()) return std::nullopt;
+        return tokenizer::internString(type);
+    }
 
-        if (!expect_operator("[").has_value()) { cTokenI = tBegin - 1; get_next(); return std::nullopt; }
+    std::optional<Statement*> Parser::expect_array_call(Statement* array) {
+        if (!expect_operator('[').has_value()) { return std::nullopt; }
 
-        std::optional<tokenizer::Token*> index = expect_integer();
+        std::optional<Statement*> index = expect_value_expression();
         if (!index.has_value()) { error(cToken, "Expected array index"); }
-        if (!expect_operator("]").has_value()) { error(cToken, "Expected ']'"); }
+        if (!expect_operator(']').has_value()) { error(cToken, "Expected ']'"); }
 
+        // element assignment
+        if (expect_operator('=').has_value()) {
+            std::optional<Statement*> value = expect_value_expression();
+            if (!value.has_value()) { error(cToken, "Expected value for the array element"); }
 
-        Statement* acs = new Statement(StatementType::ARRAY_CALL, "");
-        Statement* is = new Statement(StatementType::INTEGER_LITERAL, index.value()->value);
-        acs->statements.emplace_back(nameToken.value());
-        acs->statements.emplace_back(is);
+            Statement* aas = arena.statement(StatementType::ARRAY_ASSIGNMENT, "");
+            aas->statements = arena.array<Statement*>({array, index.value(), value.value()});
+            return aas;
+        }
 
+        Statement* acs = arena.statement(StatementType::ARRAY_CALL, "");
+        acs->statements = arena.array<Statement*>({array, index.value()});
 
         return acs;
     }
 
     std::optional<Statement*> Parser::expect_variable_call() {
-        std::optional<tokenizer::Token*> nameToken = expect_identifier();
+        std::optional<tokenizer::Token> nameToken = expect_identifier();
         if (!nameToken.has_value()) return std::nullopt;
+        tokenizer::Token name = nameToken.value();
+
+        // the token after the name decides what it is
+        if (cToken.kind == '(') { return expect_function_call(name); }
+        if (cToken.kind == '=') { return expect_variable_assignment(name); }
+
+        Statement* var = arena.statement(StatementType::VARIABLE_CALL, name.value, name.symbol);
 
-        return new Statement(StatementType::VARIABLE_CALL, nameToken.value()->value);
+        std::optional<Statement*> arrayCall = expect_array_call(var);
+        if (arrayCall.has_value()) { return arrayCall; }
+
+        return var;
     }
 
     std::optional<Statement*> Parser::expect_type_cast() {
-        if (!expect_operator("#").has_value()) { return std::nullopt; }
+        if (!expect_operator('#').has_value()) { return std::nullopt; }
 
         // expect type to cast to
-        std::optional<tokenizer::Token*> typeToken = expect_type();
-        if (!typeToken.has_value()) { --cTokenI; get_next(); return std::nullopt; }
+        std::optional<std::string_view> typeToken = expect_type();
+        if (!typeToken.has_value()) { error(cToken, "Expected type to cast to"); }
 
-        // expect value to cast
-        std::optional<Statement*> val = expect_value_expression(false, false);
+        // expect value to cast, casts bind tighter than any binary operator
+        std::optional<Statement*> val = expect_primary_expression();
         if (!val.has_value()) { error(cToken, "Expected value for a type cast"); }
 
-        Statement* stmt = new Statement(StatementType::TYPE_CAST, typeToken.value()->value);
-        stmt->statements.emplace_back(val.value());
+        Statement* stmt = arena.statement(StatementType::TYPE_CAST, typeToken.value());
+        stmt->statements = arena.array<Statement*>({val.value()});
 
         return stmt;
     }
 
-    std::optional<Statement*> Parser::expect_variable_assignment() {
-
-        int bTokenI = cTokenI;
-
-        // expect variable name
-        std::optional<tokenizer::Token*> nameToken = expect_identifier();
-        if (!nameToken.has_value()) { return std::nullopt; }
-
+    std::optional<Statement*> Parser::expect_variable_assignment(const tokenizer::Token& name) {
         // expect initialization
-        if (!expect_operator("=").has_value()) { cTokenI = bTokenI-1; get_next(); return std::nullopt; }
-        if (expect_operator("=").has_value()) { cTokenI = bTokenI-1; get_next(); return std::nullopt; }
+        if (!expect_operator('=').has_value()) { return std::nullopt; }
 
         // expect value
-        std::optional<Statement*> defVal = expect_value_expression(false, false);
+        std::optional<Statement*> defVal = expect_value_expression();
         if (!defVal.has_value()) { error(cToken, "Expected variable value (a)"); }
 
-        Statement* stmt = new Statement(StatementType::VARIABLE_ASSIGNMENT, nameToken.value()->value);
-        stmt->statements.emplace_back(defVal.value());
+        Statement* stmt = arena.statement(StatementType::VARIABLE_ASSIGNMENT, name.value, name.symbol);
+        stmt->statements = arena.array<Statement*>({defVal.value()});
         
         return stmt;
     }
 
     std::optional<Statement*> Parser::expect_variable_definition() {
-        if (!expect_identifier("var").has_value()) { return std::nullopt; }
+        if (!expect_keyword(tokenizer::TokenKind::KEYWORD_VAR).has_value()) { return std::nullopt; }
 
         // expect variable type
-        std::optional<tokenizer::Token*> typeToken = expect_type();
-        if (!typeToken.has_value()) { --cTokenI; return std::nullopt; }
+        std::optional<std::string_view> typeToken = expect_type();
+        if (!typeToken.has_value()) { error(cToken, "Expected variable type"); }
 
         // expect variable name
-        std::optional<tokenizer::Token*> nameToken = expect_identifier();
-        if (!nameToken.has_value()) { cTokenI-=2; return std::nullopt; }
+        std::optional<tokenizer::Token> nameToken = expect_identifier();
+        if (!nameToken.has_value()) { error(cToken, "Expected variable name"); }
 
-        Statement* stmt = new Statement(StatementType::VARIABLE_DEFINITON, nameToken.value()->value);
-        stmt->dataType = typeToken.value()->value;
+        Statement* stmt = arena.statement<Definition>(StatementType::VARIABLE_DEFINITON, nameToken.value().value, nameToken.value().symbol, typeToken.value());
 
         // expect initialization
-        if (!expect_operator("=").has_value()) { return stmt; }
+        if (!expect_operator('=').has_value()) { return stmt; }
 
         // expect default value
-        std::optional<Statement*> defVal = expect_value_expression(false, false);
+        std::optional<Statement*> defVal = expect_value_expression();
         if (!defVal.has_value()) { error(cToken, "Expected variable initial value"); }
 
-        stmt->statements.emplace_back(defVal.value());
+        stmt->statements = arena.array<Statement*>({defVal.value()});
         
         return stmt;
     }
 
     std::optional<Statement*> Parser::expect_import() {
          // expect "import" keyword
-        if (!expect_identifier("import").has_value()) { return std::nullopt; }
+        if (!expect_keyword(tokenizer::TokenKind::KEYWORD_IMPORT).has_value()) { return std::nullopt; }
 
         std::string name = "";
-        while (!expect_operator(";").has_value()) { 
-            name += cToken->value;
+        while (!expect_operator(';').has_value()) { 
+            name += cToken.value;
             get_next();
         }
 
-        return new Statement(StatementType::IMPORT, name);
+        return arena.statement(StatementType::IMPORT, tokenizer::internString(name));
     }
 
     std::optional<Statement*> Parser::expect_function() {
+        // calls of "const def" functions have to be evaluated at compile time
+        bool isConst = expect_keyword(tokenizer::TokenKind::KEYWORD_CONST).has_value();
+
         // expect "def" keyword
-        if (!expect_identifier("def").has_value()) { return std::nullopt; }
+        if (!expect_keyword(tokenizer::TokenKind::KEYWORD_DEF).has_value()) {
+            if (isConst) { error(cToken, "Expected 'def' after 'const'"); }
+            return std::nullopt;
+        }
 
         // expect function type
-        std::optional<tokenizer::Token*> typeToken = expect_type();
-        if (!typeToken.has_value()) { cTokenI-=2; get_next(); return std::nullopt; }
+        std::optional<std::string_view> typeToken = expect_type();
+        if (!typeToken.has_value()) { error(cToken, "Expected function type"); }
 
         // expect function name
-        std::optional<tokenizer::Token*> nameToken = expect_identifier();
-        if (!nameToken.has_value()) { cTokenI-=3; get_next(); return std::nullopt; }
+        std::optional<tokenizer::Token> nameToken = expect_identifier();
+        if (!nameToken.has_value()) { error(cToken, "Expected function name"); }
 
-        Statement* fd = new Statement(StatementType::FUNCTION_DEFINITION, nameToken.value()->value);
-        fd->dataType = typeToken.value()->value;
+        FunctionDefinition* fd = arena.statement<FunctionDefinition>(nameToken.value().value, nameToken.value().symbol, typeToken.value(), isConst);
 
         // arguments
+        llvm::SmallVector<Argument, 4> args;
         bool isFirst = true;
-        if (!expect_operator("(").has_value()) { error(cToken, "Expected '('"); }
-        while (!expect_operator(")").has_value()) {
+        if (!expect_operator('(').has_value()) { error(cToken, "Expected '('"); }
+        while (!expect_operator(')').has_value()) {
             if (!isFirst) {
-                if (!expect_operator(",").has_value()) { error(cToken, "Expected ',' to separate function arguments"); }
+                if (!expect_operator(',').has_value()) { error(cToken, "Expected ',' to separate function arguments"); }
             }
-            std::optional<tokenizer::Token*> vt = expect_type();
+            std::optional<std::string_view> vt = expect_type();
             if (!vt.has_value()) { error(cToken, "Expected argument or ')'"); }
 
-            std::optional<tokenizer::Token*> vn = expect_identifier();
-            if (!vt.has_value()) { error(cToken, "Expected argument name"); }
-
-            std::pair<std::string, std::string> arg;
-            arg.first = vt.value()->value;
-            arg.second = vn.value()->value;
+            std::optional<tokenizer::Token> vn = expect_identifier();
+            if (!vn.has_value()) { error(cToken, "Expected argument name"); }
 
-            fd->args.emplace_back(arg);
+            args.push_back({vt.value(), vn.value().value, vn.value().symbol});
             isFirst = false;
         }
+        fd->args = arena.array<Argument>(args);
 
         // function
         std::optional<Statement*> expr = expect_expression();
         if (!expr.has_value()) { error(cToken, "Expected function body"); }
-        fd->statements.emplace_back(expr.value());
+        fd->statements = arena.array<Statement*>({expr.value()});
 
 
         return fd;
     }
 
     std::optional<Statement*> Parser::expect_get_alloca()  {
-        if (!expect_operator("&").has_value()) { return std::nullopt; }
-        std::optional<tokenizer::Token*> nameToken = expect_identifier();
+        if (!expect_operator('&').has_value()) { return std::nullopt; }
+        std::optional<tokenizer::Token> nameToken = expect_identifier();
         if (!nameToken.has_value()) return std::nullopt;
 
-        Statement* stmt = new Statement(StatementType::GET_ALLOCA, nameToken.value()->value);
+        Statement* stmt = arena.statement(StatementType::GET_ALLOCA, nameToken.value().value, nameToken.value().symbol);
 
         return stmt;
     }
 
-    std::optional<Statement*> Parser::expect_function_call() {
-        std::optional<tokenizer::Token*> fName = expect_identifier();
-        if (!fName.has_value()) {return std::nullopt;}
+    std::optional<Statement*> Parser::expect_function_call(const tokenizer::Token& name) {
+        if (!expect_operator('(').has_value()) { return std::nullopt; }
 
-        Statement* fptr = new Statement(StatementType::FUNCTION_CALL, fName.value()->value);
+        Statement* fptr = arena.statement(StatementType::FUNCTION_CALL, name.value, name.symbol);
 
-        if (!expect_operator("(").has_value()) { cTokenI-=2; get_next(); return std::nullopt; }
+        llvm::SmallVector<Statement*, 8> args;
         bool isFirst = true;
-        while(!expect_operator(")").has_value()) {
+        while(!expect_operator(')').has_value()) {
             if (!isFirst) {
-                if (!expect_operator(",").has_value()) { error(cToken, "Expected ',' to separate function arguments"); }
+                if (!expect_operator(',').has_value()) { error(cToken, "Expected ',' to separate function arguments"); }
             }
 
-            std::optional<Statement*> argS = expect_value_expression(false, false);
+            std::optional<Statement*> argS = expect_value_expression();
             if (argS.has_value()) {
-                fptr->statements.emplace_back(argS.value());
+                args.emplace_back(argS.value());
             }
             isFirst = false;
         }
 
+        fptr->statements = arena.array<Statement*>(args);
         return fptr;
     }
 
+    // @unroll(N), @vectorize(width) or @novectorize in front of a for loop
+    std::optional<Statement*> Parser::expect_loop_hint() {
+        if (!expect_operator('@').has_value()) { return std::nullopt; }
+
+        std::optional<tokenizer::Token> name = expect_identifier();
+        if (!name.has_value()) { error(cToken, "Expected loop hint name"); }
+
+        Statement* hint = arena.statement(StatementType::LOOP_HINT, name.value().value);
+        if (hint->value == "novectorize") { return hint; }
+        if (hint->value != "unroll" && hint->value != "vectorize") { error(name.value(), "Unknown loop hint " + std::string(hint->value)); }
+
+        if (!expect_operator('(').has_value()) { error(cToken, "Expected '('"); }
+        std::optional<tokenizer::Token> count = expect_integer();
+        if (!count.has_value()) { error(cToken, "Expected loop hint value"); }
+        if (!expect_operator(')').has_value()) { error(cToken, "Expected ')'"); }
+
+        hint->statements = arena.array<Statement*>({arena.statement(StatementType::INTEGER_LITERAL, count.value().value)});
+        return hint;
+    }
+
     std::optional<Statement*> Parser::expect_for() {
-        // expect "if" keyword
-        if (!expect_identifier("for").has_value()) { return std::nullopt; }
-        Statement* FOR = new Statement(StatementType::FOR_LOOP, "");
+        llvm::SmallVector<Statement*, 6> parts;
+        std::optional<Statement*> hint;
+        while ((hint = expect_loop_hint()).has_value()) {
+            parts.push_back(hint.value());
+        }
+
+        // expect "for" keyword
+        if (!expect_keyword(tokenizer::TokenKind::KEYWORD_FOR).has_value()) {
+            if (!parts.empty()) { error(cToken, "Expected for loop after loop hints"); }
+            return std::nullopt;
+        }
+        Statement* FOR = arena.statement(StatementType::FOR_LOOP, "");
 
         // expect condition
-        if (!expect_operator("(").has_value()) { error(cToken, "Expected '('"); }
+        if (!expect_operator('(').has_value()) { error(cToken, "Expected '('"); }
 
         // before
-        std::optional<Statement*> beforeS = expect_value_expression(false, false);
-        if (!expect_operator(";").has_value()) { error(cToken, "Expected ';' (fl1)"); }
+        std::optional<Statement*> beforeS = expect_value_expression();
+        if (!expect_operator(';').has_value()) { error(cToken, "Expected ';' (fl1)"); }
 
-        std::optional<Statement*> testS = expect_value_expression(false, false);
-        if (!expect_operator(";").has_value()) { error(cToken, "Expected ';' (fl2)"); }
+        std::optional<Statement*> testS = expect_value_expression();
+        if (!expect_operator(';').has_value()) { error(cToken, "Expected ';' (fl2)"); }
 
-        std::optional<Statement*> afterS = expect_value_expression(false, false);
+        std::optional<Statement*> afterS = expect_value_expression();
 
-        if (!expect_operator(")").has_value()) { error(cToken, "Expected ')'"); }
-
-        FOR->statements.emplace_back(beforeS.value());
-        FOR->statements.emplace_back(testS.value());
-        FOR->statements.emplace_back(afterS.value());
+        if (!expect_operator(')').has_value()) { error(cToken, "Expected ')'"); }
 
         // expect function block
         std::optional<Statement*> forBlock = expect_expression();
         if (!forBlock.has_value()) { error(cToken, "expected for loop code block"); }
-        FOR->statements.emplace_back(forBlock.value());
+        // the hints follow the four parts of the loop
+        parts.insert(parts.begin(), {beforeS.value(), testS.value(), afterS.value(), forBlock.value()});
+        FOR->statements = arena.array<Statement*>(parts);
 
         return FOR;
     }
 
     std::optional<Statement*> Parser::expect_if() {
         // expect "if" keyword
-        if (!expect_identifier("if").has_value()) { return std::nullopt; }
-        Statement* IF = new Statement(StatementType::IF, "");
+        if (!expect_keyword(tokenizer::TokenKind::KEYWORD_IF).has_value()) { return std::nullopt; }
+        Statement* IF = arena.statement(StatementType::IF, "");
 
         // expect condition
-        if (!expect_operator("(").has_value()) { error(cToken, "Expected '('"); }
-        std::optional<Statement*> cond = expect_value_expression(false, false);
+        if (!expect_operator('(').has_value()) { error(cToken, "Expected '('"); }
+        std::optional<Statement*> cond = expect_value_expression();
         if (!cond.has_value()) { error(cToken, "Expected if condition"); }
-        IF->statements.emplace_back(cond.value());
-        if (!expect_operator(")").has_value()) { error(cToken, "Expected ')'"); }
+        if (!expect_operator(')').has_value()) { error(cToken, "Expected ')'"); }
 
         // expect function block
         std::optional<Statement*> ifBlock = expect_expression();
         if (!ifBlock.has_value()) { error(cToken, "expected if code block"); }
-        IF->statements.emplace_back(ifBlock.value());
 
         // check for else statement
-        if (!expect_identifier("else").has_value()) { return IF; }
+        if (!expect_keyword(tokenizer::TokenKind::KEYWORD_ELSE).has_value()) {
+            IF->statements = arena.array<Statement*>({cond.value(), ifBlock.value()});
+            return IF;
+        }
         IF->type = StatementType::IFELSE;
 
         // expect function block
         std::optional<Statement*> elseBlock = expect_expression();
         if (!elseBlock.has_value()) { error(cToken, "expected else code block"); }
-        IF->statements.emplace_back(elseBlock.value());
+        IF->statements = arena.array<Statement*>({cond.value(), ifBlock.value(), elseBlock.value()});
 
 
         return IF;
     }
 
-    std::optional<Statement*> Parser::expect_logic_expression() {
-        int tokenIB = cTokenI;
-        std::optional<Statement*> LHS = expect_value_expression(false, true);
-        if (!LHS.has_value()) { return std::nullopt; }
-
-        auto tmp = expect_logic_RHS(LHS.value());
-        if (!tmp.has_value()) {
-            cTokenI = tokenIB-1;
-            get_next();
-            return std::nullopt;
-        }
+    int Parser::get_precedence(const tokenizer::Token& token) {
+        if (token.type != tokenizer::TokenType::OPERATOR) { return -1; }
 
-        return tmp;
+        auto prec = operator_precedence.find(token.kind);
+        if (prec == operator_precedence.end()) { return -1; }
+        return prec->second;
     }
-    std::optional<Statement*> Parser::expect_logic_RHS(Statement* LHS) {
-        std::optional<tokenizer::Token*> OP = expect_operator("");
 
-        if (!OP.has_value() || std::find(std::begin(logic_ops), std::end(logic_ops), OP.value()->value) == std::end(logic_ops)) { return std::nullopt; }
-        std::optional<tokenizer::Token*> OPI = expect_operator("=");
+    std::optional<Statement*> Parser::expect_binary_RHS(int prec, Statement* LHS) {
+        while (true) {
+            // operators binding weaker than prec belong to the caller
+            int tokenPrec = get_precedence(cToken);
+            if (tokenPrec < prec) { return LHS; }
 
-        std::optional<Statement*> RHS = expect_value_expression(false, false);
-        if (!RHS.has_value()) { error(cToken, "Expected right side of logic operation"); }
-
-        Statement* ms = new Statement(StatementType::LOGIC_EXPRESSION, OP.value()->value + (OPI.has_value() ? OPI.value()->value : ""));
-        ms->statements.emplace_back(LHS);
-        ms->statements.emplace_back(RHS.value());
-
-        return ms;
-    }
+            tokenizer::Token OP = cToken;
+            get_next();
 
+            std::optional<Statement*> RHS = expect_primary_expression();
+            if (!RHS.has_value()) { error(cToken, "Expected right side of binary operation"); }
 
-    int get_precedence(tokenizer::Token* token) {
-        if (!isascii(token->value[0])) {
-            return -1;
-        }
+            // a stronger operator after RHS takes it as its left side, equal ones associate to the left
+            if (tokenPrec < get_precedence(cToken)) {
+                RHS = expect_binary_RHS(tokenPrec + 1, RHS.value());
+            }
 
-        int prec = operator_precedence[token->value[0]];
-        if (prec <= 0) {
-            return -1;
-        }
-        return prec;
-    }
-    std::optional<Statement*> Parser::expect_binary_expression() {
-        int tokenIB = cTokenI;
-        std::optional<Statement*> LHS = expect_value_expression(true, true);
-        if (!LHS.has_value()) { return std::nullopt; }
-        // Statement* ms = new Statement(StatementType::INTEGER_LITERAL, "1");
-        // return ms;
-        auto tmp = expect_binary_RHS(0, LHS.value(), tokenIB);
-        if (!tmp.has_value()) { 
+            bool logic = std::find(std::begin(logic_ops), std::end(logic_ops), OP.kind) != std::end(logic_ops);
+            Statement* ms = arena.statement(logic ? StatementType::LOGIC_EXPRESSION : StatementType::MATH, OP.value);
+            ms->statements = arena.array<Statement*>({LHS, RHS.value()});
+            LHS = ms;
         }
-        return tmp;
     }
-    std::optional<Statement*> Parser::expect_binary_RHS(int prec, Statement* LHS, int tokenIB) {
-        std::optional<tokenizer::Token*> OP = expect_operator("");
 
-        if (!OP.has_value() || std::find(std::begin(math_ops), std::end(math_ops), OP.value()->value) == std::end(math_ops)) { cTokenI = tokenIB-1; get_next(); return std::nullopt; }
-
-        std::optional<Statement*> RHS = expect_value_expression(false, false);
-        if (!RHS.has_value()) { error(cToken, "Expected right side of binary operation"); }
-
-        Statement* ms = new Statement(StatementType::MATH, OP.value()->value);
-        ms->statements.emplace_back(LHS);
-        ms->statements.emplace_back(RHS.value());
+    std::optional<Statement*> Parser::expect_value_expression() {
+        std::optional<Statement*> LHS = expect_primary_expression();
+        if (!LHS.has_value()) { return std::nullopt; }
 
-        return ms;
+        return expect_binary_RHS(0, LHS.value());
     }
 
-    std::optional<Statement*> Parser::expect_value_expression(bool skipBin, bool skipLog) {
+    // every kind of value is recognized by its first token, so nothing is parsed twice
+    std::optional<Statement*> Parser::expect_primary_expression() {
 
         std::optional<Statement*> cs;
 
@@ -569,50 +712,34 @@ namespace parser {
             return cs.value();
         }
 
-
         // get alloca
         if ((cs = expect_get_alloca()).has_value()) { 
             return cs.value();
         }
 
-
         // type cast
         if ((cs = expect_type_cast()).has_value()) { 
             return cs.value();
         }
 
-
-        // binary expression
-        if (!skipBin && (cs = expect_binary_expression()).has_value()) {
-            return cs.value();
-        }
-
-        // variable assignment
-        if (!skipLog && (cs = expect_variable_assignment()).has_value()) {
-            return cs.value();
-        }
-
-        if (!skipLog && (cs = expect_logic_expression()).has_value()) {
-            return cs.value();
-        }
-
-
-        // array
-        if ((cs = expect_array_call()).has_value()) {
+        // parenthesized expression
+        if (expect_operator('(').has_value()) {
+            cs = expect_value_expression();
+            if (!cs.has_value()) { error(cToken, "Expected expression"); }
+            if (!expect_operator(')').has_value()) { error(cToken, "Expected ')'"); }
             return cs.value();
         }
 
-        // function call
-        if ((cs = expect_function_call()).has_value()) { 
-            return cs.value();
+        std::optional<tokenizer::Token> ct;
+        if ((ct = expect_boolean()).has_value()) {
+            return arena.statement(StatementType::BOOLEAN_LITERAL, ct.value().value);
         }
 
-        // variable
+        // variable, assignment, function or array call
         if ((cs = expect_variable_call()).has_value()) {
             return cs.value();
         }
 
-
         // array
         if ((cs = expect_array()).has_value()) {
             return cs.value();
@@ -624,21 +751,19 @@ namespace parser {
         }
 
         // primitives
-        std::optional<tokenizer::Token*> ct;
-        if ((ct = expect_long_int()).has_value()) {
-            return new Statement(StatementType::LONG_LITERAL, ct.value()->value);
+        if ((ct = expect_integer()).has_value()) {
+            // long literals end with 'l'
+            if (cToken.kind == tokenizer::TokenKind::NAME && cToken.value == "l") {
+                get_next();
+                return arena.statement(StatementType::LONG_LITERAL, ct.value().value);
+            }
+            return arena.statement(StatementType::INTEGER_LITERAL, ct.value().value);
         }
         if ((ct = expect_char()).has_value()) {
-            return new Statement(StatementType::CHAR_LITERAL, ct.value()->value);
+            return arena.statement(StatementType::CHAR_LITERAL, ct.value().value);
         }
         if ((ct = expect_double()).has_value()) {
-            return new Statement(StatementType::DOUBLE_LITERAL, ct.value()->value);
-        }
-        if ((ct = expect_integer()).has_value()) {
-            return new Statement(StatementType::INTEGER_LITERAL, ct.value()->value);
-        }
-        if ((ct = expect_boolean()).has_value()) {
-            return new Statement(StatementType::BOOLEAN_LITERAL, ct.value()->value);
+            return arena.statement(StatementType::DOUBLE_LITERAL, ct.value().value);
         }
 
         return std::nullopt;
@@ -647,16 +772,18 @@ namespace parser {
 
     std::optional<Statement*> Parser::expect_expression(bool skip_semicolon) {
         // block
-        if (expect_operator("{").has_value()) {
-            Statement* stmt = new Statement(StatementType::CODE_BLOCK, "");
+        if (expect_operator('{').has_value()) {
+            Statement* stmt = arena.statement(StatementType::CODE_BLOCK, "");
+            llvm::SmallVector<Statement*, 16> body;
             while (true) {
-                if (expect_operator("}").has_value()) break;
+                if (expect_operator('}').has_value()) break;
 
                 std::optional<Statement*> expr = expect_expression();
-                stmt->statements.emplace_back(expr.value());
-
                 if (!expr.has_value()) { error(cToken, "Expected expression or '}'"); }
+
+                body.emplace_back(expr.value());
             }
+            stmt->statements = arena.array<Statement*>(body);
             return stmt;
         }
 
@@ -675,44 +802,33 @@ namespace parser {
         }
 
         // return
-        if (expect_identifier("return").has_value()) {
-            std::optional<Statement*> retVal = expect_value_expression(false, false);
+        if (expect_keyword(tokenizer::TokenKind::KEYWORD_RETURN).has_value()) {
+            std::optional<Statement*> retVal = expect_value_expression();
             if (!retVal.has_value()) { 
-                if (expect_operator(";").has_value()) {
+                if (expect_operator(';').has_value()) {
                     // return without return value
-                    Statement* retExpr = new Statement(StatementType::RETURN, "void");
+                    Statement* retExpr = arena.statement(StatementType::RETURN, "void");
                     return retExpr;
                 } else {
                     error(cToken, "Expected return value");
                 }
             }
 
-            Statement* retExpr = new Statement(StatementType::RETURN, "value");
-            retExpr->statements.emplace_back(retVal.value());
+            Statement* retExpr = arena.statement(StatementType::RETURN, "value");
+            retExpr->statements = arena.array<Statement*>({retVal.value()});
 
-            if (!skip_semicolon && !expect_operator(";").has_value()) { error(cToken, "Expected ';' (r)"); }
+            if (!skip_semicolon && !expect_operator(';').has_value()) { error(cToken, "Expected ';' (r)"); }
             return retExpr;
         }
 
-        // variable assignment
-        temp = expect_variable_assignment();
+        // variable assignment, definition or function call
+        temp = expect_value_expression();
         if (temp.has_value()) {
-            if (!skip_semicolon && !expect_operator(";").has_value()) { error(cToken, "Expected ';' (va)"); }
-            return temp.value();
-        }
-
-        // variable definition
-        temp = expect_variable_definition();
-        if (temp.has_value()) {
-            if (!skip_semicolon && !expect_operator(";").has_value()) { error(cToken, "Expected ';' (vd)"); }
-            return temp.value();
-        }
-
-
-        // function call
-        temp = expect_function_call();
-        if (temp.has_value()) {
-            if (!skip_semicolon && !expect_operator(";").has_value()) { error(cToken, "Expected ';' (fc)"); }
+            StatementType type = temp.value()->type;
+            if (type != StatementType::VARIABLE_ASSIGNMENT && type != StatementType::ARRAY_ASSIGNMENT && type != StatementType::VARIABLE_DEFINITON && type != StatementType::FUNCTION_CALL) {
+                error(cToken, "Expected assignment, variable definition or function call");
+            }
+            if (!skip_semicolon && !expect_operator(';').has_value()) { error(cToken, "Expected ';'"); }
             return temp.value();
         }
 
@@ -720,8 +836,8 @@ namespace parser {
     }
 
 
-    void Parser::error(tokenizer::Token* token, const std::string& message) {
-        std::cout << token->lineNo << ":" << token->charNo << std::endl;
+    void Parser::error(const tokenizer::Token& token, const std::string& message) {
+        std::cout << token.lineNo << ":" << token.charNo << std::endl;
         throw std::runtime_error(message);
     }
 
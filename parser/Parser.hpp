@@ -5,13 +5,20 @@
 #include <optional>
 #include <string>
 #include <vector>
-#include <regex>
 #include <algorithm>
+#include <mutex>
+#include <cstdlib>
 
 #include "Statements.hpp"
 #include "../tokenizer/Tokenizer.hpp"
 
+#include "llvm/Config/llvm-config.h"
+#if LLVM_VERSION_MAJOR >= 14
+#include "llvm/MC/TargetRegistry.h"
+#else
 #include "llvm/Support/TargetRegistry.h"
+#endif
+#include "llvm/MC/MCSubtargetInfo.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Host.h"
 #include "llvm/Support/TargetSelect.h"
@@ -19,6 +26,7 @@
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Target/TargetOptions.h"
 #include "llvm/ADT/Optional.h"
+#include "llvm/ADT/SmallVector.h"
 
 #include "llvm/Analysis/LoopAnalysisManager.h"
 #include "llvm/Analysis/CGSCCPassManager.h"
@@ -26,58 +34,93 @@
 #include "llvm/IR/PassManager.h"
 
 #include "llvm/IR/LegacyPassManager.h"
+#include "llvm/Transforms/IPO/ThinLTOBitcodeWriter.h"
 
 namespace parser {
 
-    const std::string data_types[] = {"void", "int", "float", "double", "long", "bool", "char"};
-    const std::string math_ops[] = {"+", "-", "*", "/"};
-    const std::string logic_ops[] = {"<", ">", "!", "="};
+    const std::string data_types[] = {"void", "int", "float", "double", "long", "bool", "char", "vec"};
+    const unsigned maxVectorLanes = 1024; // vec<T,N> is limited to this many lanes
+    const int logic_ops[] = {'<', '>', tokenizer::TokenKind::LESS_EQUAL, tokenizer::TokenKind::GREATER_EQUAL, tokenizer::TokenKind::EQUAL_EQUAL, tokenizer::TokenKind::NOT_EQUAL};
+
+    // Options that control optimization and object file emission
+    struct CompileOptions {
+        unsigned optLevel = 0;  // -O0 .. -O3
+        unsigned sizeLevel = 0; // 1 for -Os, 2 for -Oz
+        std::string cpu = "generic"; // -mcpu, "native" means host cpu
+        std::string features = "";   // -mattr, e.g. "+avx2,+fma"
+        bool ssaLocals = true;       // keep locals that are not address-taken out of memory
+        bool evalCalls = true;       // evaluate calls of pure functions with constant arguments at compile time
+        bool boundsChecks = false;   // trap on array indices outside of the array
+        std::string cacheDir = "";   // object cache for imported modules, disabled when empty
+        bool parallelImports = true; // compile imports on a pool of worker threads
+        bool emitObjects = true;     // false for the JIT and whole-program mode, imports are kept as bitcode instead
+        bool wholeProgram = false;   // link all imports into the main module before optimizing
+        bool thinLTO = false;        // emit bitcode with a ThinLTO summary instead of object code
+        bool verbose = true;         // print tokens, syntax trees and llvm ir
+    };
 
+    // Parses the source of one module, parsers of different modules can run on different threads
     class Parser {
 
         public:
 
-            static tokenizer::Token* get_next();
-            static bool is_next();
-            static std::vector<Statement*> parse(std::vector<tokenizer::Token> tokens);
-            static void saveCompilation(llvm::Module* mod, const std::string& filename);
-
-            static std::optional<Statement*> expect_function();
-            static std::optional<Statement*> expect_import();
-            static std::optional<Statement*> expect_expression(bool skip_semicolon = false);
-            static std::optional<Statement*> expect_variable_call();
-            static std::optional<Statement*> expect_array_call();
-            static std::optional<Statement*> expect_value_expression(bool skipBin, bool skipLog);
-            static std::optional<Statement*> expect_function_call();
-            static std::optional<Statement*> expect_type_cast();
-
-            static std::optional<Statement*> expect_get_alloca();
-
-            static std::optional<Statement*> expect_logic_expression();
-            static std::optional<Statement*> expect_logic_RHS(Statement* LHS);
-
-            static std::optional<Statement*> expect_binary_expression();
-            static std::optional<Statement*> expect_binary_RHS(int prec, Statement* LHS, int tokenIB);
-
-            static std::optional<Statement*> expect_variable_definition();
-            static std::optional<Statement*> expect_variable_assignment();
-            static std::optional<Statement*> expect_if();
-            static std::optional<Statement*> expect_for();
-
-            static std::optional<tokenizer::Token*> expect_identifier(const std::string& name);
-            static std::optional<tokenizer::Token*> expect_operator(const std::string& name);
-            static std::optional<tokenizer::Token*> expect_type(const std::string& name);
-            static std::optional<tokenizer::Token*> expect_integer();
-            static std::optional<tokenizer::Token*> expect_double();
-            static std::optional<tokenizer::Token*> expect_long_int();
-            static std::optional<tokenizer::Token*> expect_char();
-            static std::optional<Statement*> expect_string();
-            static std::optional<Statement*> expect_array();
-            static std::optional<tokenizer::Token*> expect_boolean();
-
-            static int get_precedence(tokenizer::Token* token);
-
-            static void error(tokenizer::Token* token, const std::string& message);
+            Parser(std::string_view source, Arena& arena);
+
+            std::vector<Statement*> parse();
+            static void saveCompilation(llvm::Module* mod, const std::string& filename, const CompileOptions& options = CompileOptions());
+            static void initializeTargets();
+            static void getTargetCPU(const CompileOptions& options, std::string& cpu, std::string& features);
+            // empty if -mcpu and -mattr name a cpu and features of the target, an error message otherwise
+            static std::string checkTarget(const CompileOptions& options);
+            // prints the cpus and features of the target, what -mcpu=help and -mattr=help show
+            static void printTargetHelp();
+            static void setTargetAttributes(llvm::Module* mod, const std::string& cpu, const std::string& features);
+            static void optimizeModule(llvm::Module* mod, llvm::TargetMachine* targetMachine, const CompileOptions& options, llvm::raw_ostream* thinLTOBitcode = nullptr);
+
+            static int get_precedence(const tokenizer::Token& token);
+
+            static void error(const tokenizer::Token& token, const std::string& message);
+
+        private:
+
+            tokenizer::Lexer lexer; // tokens are pulled one at a time, the parser never looks further ahead
+            Arena& arena;           // receives the statements
+            tokenizer::Token cToken;
+            bool ended = false;
+
+            bool get_next();
+            bool is_next();
+
+            std::optional<Statement*> expect_function();
+            std::optional<Statement*> expect_import();
+            std::optional<Statement*> expect_expression(bool skip_semicolon = false);
+            std::optional<Statement*> expect_variable_call();
+            std::optional<Statement*> expect_array_call(Statement* array);
+            std::optional<Statement*> expect_value_expression();
+            std::optional<Statement*> expect_primary_expression();
+            std::optional<Statement*> expect_function_call(const tokenizer::Token& name);
+            std::optional<Statement*> expect_type_cast();
+
+            std::optional<Statement*> expect_get_alloca();
+
+            std::optional<Statement*> expect_binary_RHS(int prec, Statement* LHS);
+
+            std::optional<Statement*> expect_variable_definition();
+            std::optional<Statement*> expect_variable_assignment(const tokenizer::Token& name);
+            std::optional<Statement*> expect_if();
+            std::optional<Statement*> expect_for();
+            std::optional<Statement*> expect_loop_hint();
+
+            std::optional<tokenizer::Token> expect_identifier();
+            std::optional<tokenizer::Token> expect_keyword(int kind);
+            std::optional<tokenizer::Token> expect_operator(int kind = tokenizer::TokenKind::NO_KIND);
+            std::optional<std::string_view> expect_type(const std::string& name = std::string());
+            std::optional<tokenizer::Token> expect_integer();
+            std::optional<tokenizer::Token> expect_double();
+            std::optional<tokenizer::Token> expect_char();
+            std::optional<Statement*> expect_string();
+            std::optional<Statement*> expect_array();
+            std::optional<tokenizer::Token> expect_boolean();
 
     };
     
@@ -3,9 +3,13 @@
 namespace parser {
     
     void Statement::debug_print(int indent) {
-        std::cout << std::string(indent*2, ' ') << "\u001B[36m" << dataType << " ";
-        for (auto arg : args) {
-            std::cout << "[" << arg.first << " " << arg.second << "] ";
+        std::cout << std::string(indent*2, ' ') << "\u001B[36m";
+        if (Definition* definition = llvm::dyn_cast<Definition>(this)) std::cout << definition->dataType;
+        std::cout << " ";
+        if (FunctionDefinition* function = llvm::dyn_cast<FunctionDefinition>(this)) {
+            for (auto& arg : function->args) {
+                std::cout << "[" << arg.type << " " << arg.name << "] ";
+            }
         }
         std::cout << "\u001B[33m" << type << " " << "\u001B[32m" << value << "\u001B[0m" << " (\n";
         for(Statement* statement : statements) {
@@ -2,10 +2,18 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
+#include <set>
+#include <memory>
+#include <type_traits>
 
 #include "llvm/IR/Value.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/Casting.h"
 
 namespace parser {
 
@@ -33,32 +41,94 @@ namespace parser {
         DOUBLE_LITERAL = 20,
         ARRAY_DEFINITION = 21,
         ARRAY_CALL = 22,
+        LOOP_HINT = 23,
+        ARRAY_ASSIGNMENT = 24,
     };
         
+    // Block of a function being compiled. The values of its variables live in per-function slots,
+    // a scope only remembers the register values it overwrote, so entering one copies nothing.
     struct Scope {
-        Scope* parent;
-        std::map<std::string, llvm::Value*> namedValues;
+        Scope* parent = nullptr;
+        llvm::SmallDenseMap<int, llvm::Value*, 4> saved; // slot -> value before this scope changed it
 
         Scope() {}
-        Scope(Scope* parent) : parent(parent) {
-            namedValues.insert(parent->namedValues.begin(), parent->namedValues.end());
-        };
+        Scope(Scope* parent) : parent(parent) {};
     };
 
+    // Argument of a function definition
+    struct Argument {
+        std::string_view type;
+        std::string_view name;
+        int symbol;
+    };
+
+    // Statements only point into the source, the symbol table and their arena, so they need no destructor.
+    // Fields that only some kinds use live in subclasses, reached with llvm::cast.
     class Statement {
         public:
             StatementType type;
-            std::string value;
-            std::vector<Statement*> statements;
-
-            std::vector<std::pair<std::string, std::string>> args; // used only for functions
-            std::string dataType; // used for some things only
-            Scope* scope;
+            int symbol; // interned value of statements that name a variable or function, -1 otherwise
+            int slot;   // variable slot in the function, set by the resolver
+            std::string_view value;
+            llvm::ArrayRef<Statement*> statements; // children, stored next to each other in the arena
 
-            Statement( StatementType type, std::string value ) : type( type ), value( value ) {};
-            virtual ~Statement() = default;
+            Statement( StatementType type, std::string_view value, int symbol = -1 ) : type( type ), symbol( symbol ), slot( -1 ), value( value ) {};
 
             void debug_print(int indent);
     };
 
+    // Variable and function definitions
+    class Definition : public Statement {
+        public:
+            std::string_view dataType;
+
+            Definition( StatementType type, std::string_view value, int symbol, std::string_view dataType ) : Statement( type, value, symbol ), dataType( dataType ) {};
+
+            static bool classof(const Statement* s) { return s->type == VARIABLE_DEFINITON || s->type == FUNCTION_DEFINITION; }
+    };
+
+    class FunctionDefinition : public Definition {
+        public:
+            llvm::ArrayRef<Argument> args;
+            bool isConst; // "const def"
+
+            FunctionDefinition( std::string_view value, int symbol, std::string_view dataType, bool isConst ) : Definition( FUNCTION_DEFINITION, value, symbol, dataType ), isConst( isConst ) {};
+
+            static bool classof(const Statement* s) { return s->type == FUNCTION_DEFINITION; }
+    };
+
+    // Owns the statements of one module and the scopes created while compiling it
+    class Arena {
+        public:
+            template<typename T = Statement, typename... Args>
+            T* statement(Args&&... args) {
+                return new (allocator.Allocate<T>()) T(std::forward<Args>(args)...);
+            }
+
+            template<typename T>
+            llvm::ArrayRef<T> array(llvm::ArrayRef<T> values) {
+                T* data = allocator.Allocate<T>(values.size());
+                std::uninitialized_copy(values.begin(), values.end(), data);
+                return llvm::ArrayRef<T>(data, values.size());
+            }
+
+            template<typename... Args>
+            Scope* scope(Args&&... args) {
+                return new (scopes.Allocate()) Scope(std::forward<Args>(args)...);
+            }
+
+            // frees everything at once, the memory is reused by the next module
+            void reset() {
+                allocator.Reset();
+                scopes.DestroyAll();
+            }
+
+        private:
+            llvm::BumpPtrAllocator allocator; // statements, children and arguments
+            llvm::SpecificBumpPtrAllocator<Scope> scopes;
+    };
+
+    static_assert(std::is_trivially_destructible<Statement>::value, "statements are freed without running destructors");
+    static_assert(std::is_trivially_destructible<FunctionDefinition>::value, "statements are freed without running destructors");
+
 }
\ No newline at end of file
@@ -1,131 +1,349 @@
 #include "Tokenizer.hpp"
 
+#include <array>
+#include <cctype>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace tokenizer {
 
-    std::vector<Token> tokenize(std::string& data) {
-        std::vector<Token> tokens;
-        Token currentToken;
-        currentToken.value = "";
-
-        for (int k = 0; k<data.size(); ++k) {
-            char cChar = data[k];
-            ++currentToken.charNo;
-            
-            if(cChar == '"') {
-                currentToken.type = TokenType::OPERATOR;
-                currentToken.value = "\"";                
-                tokens.emplace_back(currentToken);
-                currentToken.type = TokenType::IDENTIFIER;
-                currentToken.value = "";
+    enum CharClass : unsigned char {
+        IDENTIFIER_CHAR, // anything that is not one of the classes below
+        WHITESPACE_CHAR,
+        NEWLINE_CHAR,
+        DIGIT_CHAR,
+        OPERATOR_CHAR,
+        QUOTE_CHAR,
+    };
+
+    constexpr std::array<CharClass, 256> makeCharClasses() {
+        std::array<CharClass, 256> classes{};
+        for (char c : operator_list) classes[(unsigned char)c] = CharClass::OPERATOR_CHAR;
+        for (char c = '0'; c <= '9'; ++c) classes[(unsigned char)c] = CharClass::DIGIT_CHAR;
+        classes[' '] = CharClass::WHITESPACE_CHAR;
+        classes['\t'] = CharClass::WHITESPACE_CHAR;
+        classes['\n'] = CharClass::NEWLINE_CHAR;
+        classes['"'] = CharClass::QUOTE_CHAR;
+        return classes;
+    }
+
+    // one lookup per byte instead of searching operator_list
+    constexpr std::array<CharClass, 256> charClasses = makeCharClasses();
+
+    inline CharClass charClass(char c) {
+        return charClasses[(unsigned char)c];
+    }
+
+    // number of characters of class cls starting at k
+    // blocks of 16 spaces/tabs, digits or ascii letters are skipped with sse2, the table handles everything else
+    inline int scanRun(const std::string_view& data, size_t k, CharClass cls) {
+        size_t i = k;
+#if defined(__SSE2__)
+        while (i + 16 <= data.size()) {
+            __m128i c = _mm_loadu_si128((const __m128i*)(data.data() + i));
+            __m128i match;
+            if (cls == CharClass::WHITESPACE_CHAR) {
+                match = _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(c, _mm_set1_epi8('\t')));
+            } else if (cls == CharClass::DIGIT_CHAR) {
+                match = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+            } else {
+                // setting bit 5 maps upper case letters to lower case and nothing else into a-z
+                __m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+                match = _mm_or_si128(
+                    _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1))),
+                    _mm_cmpeq_epi8(c, _mm_set1_epi8('_')));
+            }
+
+            unsigned mask = _mm_movemask_epi8(match);
+            if (mask != 0xFFFF) {
+                i += __builtin_ctz(~mask);
+                break;
+            }
+            i += 16;
+        }
+#endif
+        while (i < data.size() && charClass(data[i]) == cls) ++i;
+        return i - k;
+    }
+
+    // grow token by the next character of the source, token values are always contiguous
+    inline void extend(Token& token, const std::string_view& data, size_t k, int n = 1) {
+        if (token.value.empty()) token.value = data.substr(k, n);
+        else token.value = std::string_view(token.value.data(), token.value.size() + n);
+    }
+
+    // extend token by the whole run of characters like data[k] and move k to its last character
+    inline void extendRun(Token& token, const std::string_view& data, size_t& k) {
+        int n = scanRun(data, k, charClass(data[k]));
+        extend(token, data, k, n);
+        token.charNo += n - 1;
+        k += n - 1;
+    }
+
+    struct Keyword {
+        std::string_view name;
+        TokenKind kind;
+    };
+
+    const Keyword keywords[] = {
+        {"def", TokenKind::KEYWORD_DEF},
+        {"var", TokenKind::KEYWORD_VAR},
+        {"if", TokenKind::KEYWORD_IF},
+        {"else", TokenKind::KEYWORD_ELSE},
+        {"for", TokenKind::KEYWORD_FOR},
+        {"return", TokenKind::KEYWORD_RETURN},
+        {"import", TokenKind::KEYWORD_IMPORT},
+        {"const", TokenKind::KEYWORD_CONST},
+    };
+
+    // [A-Za-z_][A-Za-z0-9_]*
+    bool validName(std::string_view name) {
+        if (name.empty() || isdigit((unsigned char)name[0])) return false;
+        for (char c : name) {
+            if (!isalnum((unsigned char)c) && c != '_') return false;
+        }
+        return true;
+    }
+
+    int tokenKind(const Token& token) {
+        if (token.type == TokenType::OPERATOR) {
+            if (token.value.size() == 1) return (unsigned char)token.value[0];
+            switch (token.value[0]) {
+                case '<': return TokenKind::LESS_EQUAL;
+                case '>': return TokenKind::GREATER_EQUAL;
+                case '=': return TokenKind::EQUAL_EQUAL;
+                case '!': return TokenKind::NOT_EQUAL;
+            }
+        } else if (token.type == TokenType::IDENTIFIER) {
+            for (const Keyword& keyword : keywords) {
+                if (token.value == keyword.name) return keyword.kind;
+            }
+            return validName(token.value) ? TokenKind::NAME : TokenKind::NO_KIND;
+        }
+        return TokenKind::NO_KIND;
+    }
+
+    Lexer::Lexer(std::string_view data) : data(data) {}
+
+    // finished tokens get their kind once, so the parser never compares strings
+    void Lexer::finish(Token& token) {
+        token.kind = tokenKind(token);
+        token.symbol = (token.kind == TokenKind::NAME ? internSymbol(token.value) : -1);
+        pending.emplace_back(token);
+        ++count;
+    }
+
+    bool Lexer::next(Token& token) {
+        // the newest token may still be merged with the characters after it, e.g. "." and "5"
+        while (pending.size() < 2 && k < data.size()) {
+            scan();
+        }
+
+        if (k >= data.size() && currentToken.type != TokenType::UNDEFINED) {
+            finish(currentToken);
+            currentToken.type = TokenType::UNDEFINED;
+        }
+
+        if (pending.empty()) return false;
+        token = pending.front();
+        pending.pop_front();
+        return true;
+    }
+
+    // consume the character at k and everything that belongs to the same token
+    void Lexer::scan() {
+        char cChar = data[k];
+        CharClass cClass = charClass(cChar);
+        ++currentToken.charNo;
+        
+        if (cClass == CharClass::QUOTE_CHAR) {
+            currentToken.type = TokenType::OPERATOR;
+            currentToken.value = data.substr(k, 1);
+            finish(currentToken);
+            currentToken.type = TokenType::IDENTIFIER;
+            currentToken.value = std::string_view();
+            ++k;
+
+            // string contents stay escaped, see unescape()
+            size_t begin = k;
+            while (k < data.size() && data[k] != '"') {
+                if (data[k] == '\\') ++k;
                 ++k;
-                cChar = data[k];
-
-                while (cChar != '"') {
-                    if (cChar == '\\') {
-                        ++k;
-                        cChar = data[k];
-                        if (cChar == 'n') {
-                            currentToken.value.append(1, '\n');
-                        } else if (cChar == 't') {
-                            currentToken.value.append(1, '\t');
-                        }
-                    } else {
-                        currentToken.value.append(1, cChar);
-                    }
-                    ++k;
-                    cChar = data[k];
-                }    
-
-                tokens.emplace_back(currentToken);
-                currentToken.type = TokenType::OPERATOR;
-                currentToken.value = "\"";                
-                tokens.emplace_back(currentToken);
-                currentToken.type = TokenType::UNDEFINED;
-                currentToken.value = "";
-            } else if (cChar == ' ' || cChar == '\n' || cChar == '\t') { // whitespace, new line etc
-                    if (currentToken.type != TokenType::UNDEFINED) {
-                        tokens.emplace_back(currentToken);
-                        currentToken.type = TokenType::UNDEFINED;
-                        currentToken.value = "";
-                    }
-                    if (cChar == '\n') { currentToken.charNo = 0; currentToken.lineNo++; }
-
-            } else if (isdigit(cChar)) { // number
-                if (tokens.size() > 1 && tokens[tokens.size() - 1].value == ".") {
-                    Token* t = &tokens[tokens.size() - 1];
-                    t->type = TokenType::DOUBLE;
-                    t->value.append(1, cChar);
-                } else if (currentToken.type == TokenType::INTEGER || currentToken.type == TokenType::DOUBLE) {
-                    currentToken.value.append(1, cChar);
-                } else if (currentToken.type == TokenType::UNDEFINED) {
-                    currentToken.type = TokenType::INTEGER;
-                    currentToken.value.append(1, cChar);
-                } else {
-                    if (currentToken.type != TokenType::UNDEFINED) {
-                        tokens.emplace_back(currentToken);
-                        currentToken.type = TokenType::UNDEFINED;
-                        currentToken.value = "";
-                    }
-                }
+            }
+            if (k >= data.size()) {
+                std::cout << currentToken.lineNo << ":" << currentToken.charNo << std::endl;
+                throw std::runtime_error("Unterminated string literal");
+            }
+            currentToken.value = data.substr(begin, k - begin);
 
-            } else if (std::find(std::begin(operator_list), std::end(operator_list), cChar) != std::end(operator_list)) { // operator
+            finish(currentToken);
+            currentToken.type = TokenType::OPERATOR;
+            currentToken.value = data.substr(k, 1);
+            finish(currentToken);
+            currentToken.type = TokenType::UNDEFINED;
+            currentToken.value = std::string_view();
+        } else if (cClass == CharClass::WHITESPACE_CHAR || cClass == CharClass::NEWLINE_CHAR) { // whitespace, new line etc
+                if (currentToken.type != TokenType::UNDEFINED) {
+                    finish(currentToken);
+                    currentToken.type = TokenType::UNDEFINED;
+                    currentToken.value = std::string_view();
+                }
+                if (cClass == CharClass::NEWLINE_CHAR) { currentToken.charNo = 0; currentToken.lineNo++; }
+                else {
+                    // skip indentation in one go
+                    int n = scanRun(data, k, cClass);
+                    currentToken.charNo += n - 1;
+                    k += n - 1;
+                }
 
-                if (cChar == '.' && currentToken.type == TokenType::INTEGER) {
-                    currentToken.type = TokenType::DOUBLE;
-                    currentToken.value.append(1, cChar);
-                    continue;
-                } else if (currentToken.type != TokenType::UNDEFINED) {
-                    tokens.emplace_back(currentToken);
+        } else if (cClass == CharClass::DIGIT_CHAR) { // number
+            if (count > 1 && pending.back().value == "." && currentToken.type == TokenType::UNDEFINED && data[k - 1] == '.') {
+                Token* t = &pending.back();
+                t->type = TokenType::DOUBLE;
+                t->kind = TokenKind::NO_KIND;
+                extend(*t, data, k);
+            } else if (currentToken.type == TokenType::INTEGER || currentToken.type == TokenType::DOUBLE) {
+                extendRun(currentToken, data, k);
+            } else if (currentToken.type == TokenType::UNDEFINED) {
+                currentToken.type = TokenType::INTEGER;
+                extendRun(currentToken, data, k);
+            } else {
+                if (currentToken.type != TokenType::UNDEFINED) {
+                    finish(currentToken);
                     currentToken.type = TokenType::UNDEFINED;
-                    currentToken.value = "";
+                    currentToken.value = std::string_view();
                 }
-                    
-                currentToken.type = TokenType::OPERATOR;
-                currentToken.value.append(1, cChar);
+            }
+
+        } else if (cClass == CharClass::OPERATOR_CHAR) { // operator
 
-                tokens.emplace_back(currentToken);
+            if (cChar == '.' && currentToken.type == TokenType::INTEGER) {
+                currentToken.type = TokenType::DOUBLE;
+                extend(currentToken, data, k);
+                ++k;
+                return;
+            } else if (currentToken.type != TokenType::UNDEFINED) {
+                finish(currentToken);
                 currentToken.type = TokenType::UNDEFINED;
-                currentToken.value = "";
-
-            } else { // identifier
-                if (tokens.size() > 1 && tokens[tokens.size() - 1].value == "\\") {
-                    Token* t = &tokens[tokens.size() - 1];
-                    t->type = TokenType::IDENTIFIER;
-                    if (cChar == 'n') {
-                        t->value = "\n";
-                    } else if (cChar == 't') {
-                        t->value = "\t";
-                    } else if (cChar == 's') {
-                        t->value = " ";
-                    }
+                currentToken.value = std::string_view();
+            }
+                
+            currentToken.type = TokenType::OPERATOR;
+            extend(currentToken, data, k);
 
-                    currentToken.type = TokenType::UNDEFINED;
-                    currentToken.value = "";
-                    
-                } else if (currentToken.type == TokenType::UNDEFINED) {
+            // <=, >=, == and != are single tokens
+            if ((cChar == '<' || cChar == '>' || cChar == '=' || cChar == '!') && k + 1 < data.size() && data[k + 1] == '=') {
+                ++k;
+                ++currentToken.charNo;
+                extend(currentToken, data, k);
+            }
+
+            finish(currentToken);
+            currentToken.type = TokenType::UNDEFINED;
+            currentToken.value = std::string_view();
+
+        } else { // identifier
+            if (count > 1 && pending.back().value == "\\") {
+                Token* t = &pending.back();
+                t->type = TokenType::IDENTIFIER;
+                t->kind = TokenKind::NO_KIND; // only valid inside strings
+                if (cChar == 'n') {
+                    t->value = "\n";
+                } else if (cChar == 't') {
+                    t->value = "\t";
+                } else if (cChar == 's') {
+                    t->value = " ";
+                }
+
+                currentToken.type = TokenType::UNDEFINED;
+                currentToken.value = std::string_view();
+                
+            } else if (currentToken.type == TokenType::UNDEFINED) {
+                currentToken.type = TokenType::IDENTIFIER;
+                extendRun(currentToken, data, k);
+            } else if (currentToken.type == TokenType::IDENTIFIER) {
+                extendRun(currentToken, data, k);
+            } else {
+                if (currentToken.type != TokenType::UNDEFINED) {
+                    finish(currentToken);
                     currentToken.type = TokenType::IDENTIFIER;
-                    currentToken.value.append(1, cChar);
-                } else if (currentToken.type == TokenType::IDENTIFIER) {
-                    currentToken.value.append(1, cChar);
-                } else {
-                    if (currentToken.type != TokenType::UNDEFINED) {
-                        tokens.emplace_back(currentToken);
-                        currentToken.type = TokenType::IDENTIFIER;
-                        currentToken.value = cChar;
-                    }
+                    currentToken.value = std::string_view();
+                    extendRun(currentToken, data, k);
                 }
             }
-
         }
 
-        if (currentToken.type != TokenType::UNDEFINED)
-            tokens.emplace_back(currentToken);
+        ++k;
+    }
+
+    std::vector<Token> tokenize(std::string_view data) {
+        std::vector<Token> tokens;
+        tokens.reserve(data.size() / 4); // about one token every three to four characters
+
+        Lexer lexer(data);
+        Token token;
+        while (lexer.next(token)) {
+            tokens.emplace_back(token);
+        }
 
         return tokens;
     }
 
+    std::string unescape(std::string_view value) {
+        std::string result;
+        result.reserve(value.size());
+
+        for (size_t k = 0; k < value.size(); ++k) {
+            if (value[k] != '\\') {
+                result += value[k];
+                continue;
+            }
+
+            ++k;
+            if (k >= value.size()) break;
+            if (value[k] == 'n') {
+                result += '\n';
+            } else if (value[k] == 't') {
+                result += '\t';
+            }
+        }
+
+        return result;
+    }
+
+    // names live in a deque so views of them and references to them stay valid
+    std::deque<std::string> symbolNames;
+    std::unordered_map<std::string_view, int> symbolIds;
+    std::mutex symbolsMutex;
+
+    int internSymbol(std::string_view name) {
+        std::lock_guard<std::mutex> lock(symbolsMutex);
+        auto it = symbolIds.find(name);
+        if (it != symbolIds.end()) return it->second;
+
+        int symbol = symbolNames.size();
+        symbolNames.emplace_back(name);
+        symbolIds.emplace(symbolNames.back(), symbol);
+        return symbol;
+    }
+
+    const std::string& symbolName(int symbol) {
+        std::lock_guard<std::mutex> lock(symbolsMutex);
+        return symbolNames[symbol];
+    }
+
+    std::string_view internString(std::string_view value) {
+        return symbolName(internSymbol(value));
+    }
+
     void Token::debug_print() {
         std::cout << "\u001B[33mToken \u001B[0m(\u001B[36m" << type << "\u001B[0m,\u001B[36m \"" << value << "\"\u001B[0m,\u001B[36m " << lineNo << ":" << charNo << "\u001B[0m)\n";
     }
 
-}
\ No newline at end of file
+}
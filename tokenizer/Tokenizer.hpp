@@ -1,13 +1,15 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include <deque>
 #include <iostream>
 #include <algorithm>
 
 namespace tokenizer {
 
-    const char operator_list[] = {'(', ')', '{', '}', ';', ':', ',', '.', '[', ']', '=', '+', '-', '/', '\\', '*', '#', '<', '>', '"', '\'', '&'};
+    constexpr char operator_list[] = {'(', ')', '{', '}', ';', ':', ',', '.', '[', ']', '=', '+', '-', '/', '\\', '*', '#', '<', '>', '"', '\'', '&', '!', '@'};
 
     // Different types of tokens
     enum TokenType {
@@ -20,9 +22,33 @@ namespace tokenizer {
         CHAR = 5,
     };
 
+    // What a token is, single character operators use the character itself
+    enum TokenKind {
+        NO_KIND = 0,
+        NAME = 256, // identifier that is not a keyword
+
+        // operators made of two characters
+        LESS_EQUAL,
+        GREATER_EQUAL,
+        EQUAL_EQUAL,
+        NOT_EQUAL,
+
+        // reserved words
+        KEYWORD_DEF,
+        KEYWORD_VAR,
+        KEYWORD_IF,
+        KEYWORD_ELSE,
+        KEYWORD_FOR,
+        KEYWORD_RETURN,
+        KEYWORD_IMPORT,
+        KEYWORD_CONST,
+    };
+
     struct Token {
         enum TokenType type{TokenType::UNDEFINED};
-        std::string value;
+        int kind{TokenKind::NO_KIND};
+        int symbol{-1}; // interned name, only set for NAME tokens
+        std::string_view value; // points into the tokenized source, which has to outlive the token
 
         int lineNo{0};
         int charNo{0};
@@ -30,7 +56,36 @@ namespace tokenizer {
         void debug_print();
     };
 
-    // Main tokenizer method
-    std::vector<Token> tokenize(std::string& data);
+    // Pull based tokenizer, only tokens that can still change are buffered
+    class Lexer {
+        public:
+            Lexer(std::string_view data);
+
+            // false at the end of the source
+            bool next(Token& token);
+
+        private:
+            void scan();
+            void finish(Token& token);
+
+            std::string_view data;
+            size_t k = 0;
+            Token currentToken;
+            std::deque<Token> pending; // finished tokens, the newest one can still be merged with what follows
+            int count = 0;             // tokens finished so far
+    };
+
+    // Whole source at once, for printing and tools
+    std::vector<Token> tokenize(std::string_view data);
+
+    // Process escape sequences of a string literal token
+    std::string unescape(std::string_view value);
+
+    // Symbol table shared by all modules, equal names always get the same id
+    int internSymbol(std::string_view name);
+    const std::string& symbolName(int symbol);
+
+    // Text built by the parser, kept in the symbol table so equal strings are stored once
+    std::string_view internString(std::string_view value);
 
 }
\ No newline at end of file